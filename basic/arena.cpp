@@ -0,0 +1,64 @@
+#include <arena.h>
+
+#include <algorithm>
+
+void* Arena::Allocate(size_t size, size_t align) {
+    while (true) {
+        auto pos = reinterpret_cast<uintptr_t>(pos_);
+        auto aligned = (pos + align - 1) & ~(align - 1);
+        if (pos_ != nullptr && aligned + size <= reinterpret_cast<uintptr_t>(end_)) {
+            pos_ = reinterpret_cast<char*>(aligned + size);
+            return reinterpret_cast<void*>(aligned);
+        }
+        if (pos_ != nullptr) {
+            used_before_current_ += chunks_[current_].size;
+            ++current_;
+        }
+        if (current_ == chunks_.size()) {
+            size_t chunk = chunks_.empty() ? kFirstChunk : chunks_.back().size * 2;
+            chunk = std::max(chunk, size + align);
+            chunks_.push_back({std::make_unique<char[]>(chunk), chunk});
+        }
+        pos_ = chunks_[current_].data.get();
+        end_ = pos_ + chunks_[current_].size;
+    }
+}
+
+void Arena::Reset() {
+    current_ = 0;
+    used_before_current_ = 0;
+    pos_ = end_ = nullptr;
+    if (!chunks_.empty()) {
+        pos_ = chunks_[0].data.get();
+        end_ = pos_ + chunks_[0].size;
+    }
+}
+
+size_t Arena::GetUsed() const {
+    if (pos_ == nullptr) {
+        return 0;
+    }
+    return used_before_current_ + (pos_ - chunks_[current_].data.get());
+}
+
+size_t Arena::GetCapacity() const {
+    size_t capacity = 0;
+    for (const auto& chunk : chunks_) {
+        capacity += chunk.size;
+    }
+    return capacity;
+}
+
+static thread_local Arena* current_arena = nullptr;
+
+Arena* GetCurrentArena() {
+    return current_arena;
+}
+
+ArenaScope::ArenaScope(Arena* arena) : previous_(current_arena) {
+    current_arena = arena;
+}
+
+ArenaScope::~ArenaScope() {
+    current_arena = previous_;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for objects that all die together. Reset() frees everything at once
+// but keeps the chunks, so a warmed arena doesn't call malloc any more.
+class Arena {
+public:
+    Arena() = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* Allocate(size_t size, size_t align);
+
+    void Reset();
+
+    size_t GetUsed() const;
+
+    size_t GetCapacity() const;
+
+private:
+    static constexpr size_t kFirstChunk = 64 << 10;
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks_;
+    size_t current_ = 0;
+    size_t used_before_current_ = 0;
+    char* pos_ = nullptr;
+    char* end_ = nullptr;
+};
+
+// Arena that New() allocates from on this thread, nullptr means the general heap.
+Arena* GetCurrentArena();
+
+// Makes an arena current until the end of the scope.
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena* arena);
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    ~ArenaScope();
+
+private:
+    Arena* previous_;
+};
@@ -0,0 +1,415 @@
+#include <bigint.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+using Limbs = std::vector<uint32_t>;
+
+// Below this many limbs in the shorter operand the schoolbook product is faster.
+static constexpr size_t kKaratsubaThreshold = 32;
+
+static constexpr uint64_t kBase = uint64_t{1} << 32;
+static constexpr uint32_t kDecimalChunk = 1'000'000'000;
+static constexpr int kDecimalChunkDigits = 9;
+
+static void Trim(Limbs* limbs) {
+    while (!limbs->empty() && limbs->back() == 0) {
+        limbs->pop_back();
+    }
+}
+
+static int CompareMagnitude(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size()) {
+        return a.size() < b.size() ? -1 : 1;
+    }
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// Adds x * kBase^shift to the result in place.
+static void AddShifted(Limbs* result, const Limbs& x, size_t shift) {
+    if (result->size() < x.size() + shift + 1) {
+        result->resize(x.size() + shift + 1);
+    }
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < x.size(); ++i) {
+        carry += uint64_t{(*result)[i + shift]} + x[i];
+        (*result)[i + shift] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    for (i += shift; carry; ++i) {
+        if (i == result->size()) {
+            result->push_back(0);
+        }
+        carry += (*result)[i];
+        (*result)[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+}
+
+static Limbs AddMagnitude(const Limbs& a, const Limbs& b) {
+    Limbs result = a;
+    AddShifted(&result, b, 0);
+    Trim(&result);
+    return result;
+}
+
+// Requires a >= b.
+static Limbs SubtractMagnitude(const Limbs& a, const Limbs& b) {
+    Limbs result = a;
+    int64_t borrow = 0;
+    for (size_t i = 0; i < result.size(); ++i) {
+        int64_t diff = int64_t{result[i]} - borrow - (i < b.size() ? int64_t{b[i]} : 0);
+        borrow = diff < 0;
+        result[i] = static_cast<uint32_t>(diff);
+        if (!borrow && i >= b.size()) {
+            break;
+        }
+    }
+    Trim(&result);
+    return result;
+}
+
+static Limbs SchoolbookMultiply(const Limbs& a, const Limbs& b) {
+    Limbs result(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); ++j) {
+            carry += uint64_t{a[i]} * b[j] + result[i + j];
+            result[i + j] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+        result[i + b.size()] = static_cast<uint32_t>(carry);
+    }
+    Trim(&result);
+    return result;
+}
+
+static Limbs Slice(const Limbs& limbs, size_t from, size_t to) {
+    Limbs result(limbs.begin() + std::min(from, limbs.size()),
+                 limbs.begin() + std::min(to, limbs.size()));
+    Trim(&result);
+    return result;
+}
+
+static Limbs MultiplyMagnitude(const Limbs& a, const Limbs& b) {
+    if (a.size() < b.size()) {
+        return MultiplyMagnitude(b, a);
+    }
+    if (b.size() < kKaratsubaThreshold) {
+        return SchoolbookMultiply(a, b);
+    }
+    size_t half = a.size() / 2;
+    Limbs result;
+    auto a_low = Slice(a, 0, half);
+    auto a_high = Slice(a, half, a.size());
+    if (b.size() <= half) {
+        // Too lopsided to split both, multiply b by each half of a.
+        AddShifted(&result, MultiplyMagnitude(a_low, b), 0);
+        AddShifted(&result, MultiplyMagnitude(a_high, b), half);
+        Trim(&result);
+        return result;
+    }
+    auto b_low = Slice(b, 0, half);
+    auto b_high = Slice(b, half, b.size());
+    auto low = MultiplyMagnitude(a_low, b_low);
+    auto high = MultiplyMagnitude(a_high, b_high);
+    auto middle = MultiplyMagnitude(AddMagnitude(a_low, a_high), AddMagnitude(b_low, b_high));
+    middle = SubtractMagnitude(SubtractMagnitude(middle, low), high);
+    AddShifted(&result, low, 0);
+    AddShifted(&result, middle, half);
+    AddShifted(&result, high, 2 * half);
+    Trim(&result);
+    return result;
+}
+
+static uint32_t DivideSmall(Limbs* limbs, uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t i = limbs->size(); i-- > 0;) {
+        uint64_t current = (remainder << 32) | (*limbs)[i];
+        (*limbs)[i] = static_cast<uint32_t>(current / divisor);
+        remainder = current % divisor;
+    }
+    Trim(limbs);
+    return static_cast<uint32_t>(remainder);
+}
+
+static void MultiplyAddSmall(Limbs* limbs, uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+    for (auto& limb : *limbs) {
+        carry += uint64_t{limb} * factor;
+        limb = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    if (carry) {
+        limbs->push_back(static_cast<uint32_t>(carry));
+    }
+}
+
+// Knuth's algorithm D on normalized operands, b has at least two limbs and a >= b.
+static void DivModMagnitude(const Limbs& a, const Limbs& b, Limbs* quotient, Limbs* remainder) {
+    int shift = __builtin_clz(b.back());
+    size_t n = b.size();
+    size_t m = a.size() - n;
+    Limbs v(n);
+    Limbs u(a.size() + 1);
+    for (size_t i = n; i-- > 0;) {
+        v[i] = (b[i] << shift) | (shift && i ? b[i - 1] >> (32 - shift) : 0);
+    }
+    u[a.size()] = shift ? a.back() >> (32 - shift) : 0;
+    for (size_t i = a.size(); i-- > 0;) {
+        u[i] = (a[i] << shift) | (shift && i ? a[i - 1] >> (32 - shift) : 0);
+    }
+
+    quotient->assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;) {
+        uint64_t top = (uint64_t{u[j + n]} << 32) | u[j + n - 1];
+        uint64_t guess = top / v[n - 1];
+        uint64_t rest = top % v[n - 1];
+        while (guess >= kBase || guess * v[n - 2] > ((rest << 32) | u[j + n - 2])) {
+            --guess;
+            rest += v[n - 1];
+            if (rest >= kBase) {
+                break;
+            }
+        }
+        int64_t borrow = 0;
+        int64_t diff;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t product = guess * v[i];
+            diff = int64_t{u[i + j]} - borrow - static_cast<int64_t>(product & 0xffffffff);
+            u[i + j] = static_cast<uint32_t>(diff);
+            borrow = static_cast<int64_t>(product >> 32) - (diff >> 32);
+        }
+        diff = int64_t{u[j + n]} - borrow;
+        u[j + n] = static_cast<uint32_t>(diff);
+        if (diff < 0) {
+            // The guess was one too big, add the divisor back.
+            --guess;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                carry += uint64_t{u[i + j]} + v[i];
+                u[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+            u[j + n] += static_cast<uint32_t>(carry);
+        }
+        (*quotient)[j] = static_cast<uint32_t>(guess);
+    }
+    Trim(quotient);
+
+    remainder->assign(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        (*remainder)[i] = (u[i] >> shift) | (shift ? u[i + 1] << (32 - shift) : 0);
+    }
+    Trim(remainder);
+}
+
+BigInt::BigInt(int64_t value) : negative_(value < 0) {
+    uint64_t magnitude = negative_ ? ~static_cast<uint64_t>(value) + 1 : value;
+    while (magnitude) {
+        limbs_.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInt::BigInt(Limbs limbs, bool negative) : limbs_(std::move(limbs)) {
+    negative_ = negative && !limbs_.empty();
+}
+
+BigInt BigInt::FromString(std::string_view string) {
+    bool negative = false;
+    if (!string.empty() && (string[0] == '-' || string[0] == '+')) {
+        negative = string[0] == '-';
+        string.remove_prefix(1);
+    }
+    if (string.empty()) {
+        throw std::invalid_argument("Empty number");
+    }
+    Limbs limbs;
+    size_t chunk = string.size() % kDecimalChunkDigits;
+    if (chunk == 0) {
+        chunk = kDecimalChunkDigits;
+    }
+    for (size_t i = 0; i < string.size(); i += chunk, chunk = kDecimalChunkDigits) {
+        uint32_t value = 0;
+        uint32_t scale = 1;
+        for (size_t j = i; j < i + chunk; ++j) {
+            if (string[j] < '0' || string[j] > '9') {
+                throw std::invalid_argument("Invalid digit");
+            }
+            value = value * 10 + (string[j] - '0');
+            scale *= 10;
+        }
+        MultiplyAddSmall(&limbs, scale, value);
+    }
+    Trim(&limbs);
+    return BigInt(std::move(limbs), negative);
+}
+
+bool BigInt::IsZero() const {
+    return limbs_.empty();
+}
+
+bool BigInt::IsNegative() const {
+    return negative_;
+}
+
+bool BigInt::FitsInt64() const {
+    if (limbs_.size() <= 1) {
+        return true;
+    }
+    if (limbs_.size() > 2) {
+        return false;
+    }
+    uint64_t magnitude = (uint64_t{limbs_[1]} << 32) | limbs_[0];
+    return magnitude < (uint64_t{1} << 63) || (negative_ && magnitude == (uint64_t{1} << 63));
+}
+
+int64_t BigInt::ToInt64() const {
+    uint64_t magnitude = 0;
+    for (size_t i = std::min<size_t>(limbs_.size(), 2); i-- > 0;) {
+        magnitude = (magnitude << 32) | limbs_[i];
+    }
+    return static_cast<int64_t>(negative_ ? ~magnitude + 1 : magnitude);
+}
+
+std::string BigInt::ToString() const {
+    if (limbs_.empty()) {
+        return "0";
+    }
+    std::vector<uint32_t> chunks;
+    Limbs rest = limbs_;
+    while (!rest.empty()) {
+        chunks.push_back(DivideSmall(&rest, kDecimalChunk));
+    }
+    std::string result = negative_ ? "-" : "";
+    result += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        auto chunk = std::to_string(chunks[i]);
+        result.append(kDecimalChunkDigits - chunk.size(), '0');
+        result += chunk;
+    }
+    return result;
+}
+
+BigInt BigInt::operator-() const {
+    return BigInt(limbs_, !negative_);
+}
+
+BigInt BigInt::Abs() const {
+    return BigInt(limbs_, false);
+}
+
+BigInt operator+(const BigInt& a, const BigInt& b) {
+    if (a.negative_ == b.negative_) {
+        return BigInt(AddMagnitude(a.limbs_, b.limbs_), a.negative_);
+    }
+    if (CompareMagnitude(a.limbs_, b.limbs_) >= 0) {
+        return BigInt(SubtractMagnitude(a.limbs_, b.limbs_), a.negative_);
+    }
+    return BigInt(SubtractMagnitude(b.limbs_, a.limbs_), b.negative_);
+}
+
+BigInt operator-(const BigInt& a, const BigInt& b) {
+    return a + -b;
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b) {
+    return BigInt(MultiplyMagnitude(a.limbs_, b.limbs_), a.negative_ != b.negative_);
+}
+
+void BigInt::DivMod(const BigInt& a, const BigInt& b, BigInt* quotient, BigInt* remainder) {
+    if (b.IsZero()) {
+        throw std::domain_error("Division by zero");
+    }
+    Limbs q;
+    Limbs r;
+    if (CompareMagnitude(a.limbs_, b.limbs_) < 0) {
+        r = a.limbs_;
+    } else if (b.limbs_.size() == 1) {
+        q = a.limbs_;
+        if (auto rest = DivideSmall(&q, b.limbs_[0])) {
+            r.push_back(rest);
+        }
+    } else {
+        DivModMagnitude(a.limbs_, b.limbs_, &q, &r);
+    }
+    if (quotient) {
+        *quotient = BigInt(std::move(q), a.negative_ != b.negative_);
+    }
+    if (remainder) {
+        *remainder = BigInt(std::move(r), a.negative_);
+    }
+}
+
+int Compare(const BigInt& a, const BigInt& b) {
+    if (a.negative_ != b.negative_) {
+        return a.negative_ ? -1 : 1;
+    }
+    int magnitude = CompareMagnitude(a.limbs_, b.limbs_);
+    return a.negative_ ? -magnitude : magnitude;
+}
+
+BigInt BigInt::Pow(const BigInt& base, uint64_t exponent) {
+    BigInt result = 1;
+    BigInt square = base;
+    while (exponent) {
+        if (exponent & 1) {
+            result = result * square;
+        }
+        exponent >>= 1;
+        if (exponent) {
+            square = square * square;
+        }
+    }
+    return result;
+}
+
+BigInt BigInt::ModPow(const BigInt& base, const BigInt& exponent, const BigInt& modulus) {
+    if (exponent.IsNegative()) {
+        throw std::domain_error("Negative exponent");
+    }
+    auto m = modulus.Abs();
+    BigInt reduced;
+    DivMod(base, m, nullptr, &reduced);
+    if (reduced.IsNegative()) {
+        reduced = reduced + m;
+    }
+
+    if (m.FitsInt64()) {
+        // Everything fits in a machine word, and products in two.
+        auto word_modulus = static_cast<unsigned __int128>(m.ToInt64());
+        unsigned __int128 result = 1 % word_modulus;
+        unsigned __int128 square = static_cast<uint64_t>(reduced.ToInt64());
+        for (size_t i = 0; i < exponent.limbs_.size(); ++i) {
+            uint32_t bits = exponent.limbs_[i];
+            bool last = i + 1 == exponent.limbs_.size();
+            for (int bit = 0; bit < 32 && (!last || bits); ++bit, bits >>= 1) {
+                if (bits & 1) {
+                    result = result * square % word_modulus;
+                }
+                square = square * square % word_modulus;
+            }
+        }
+        return BigInt(static_cast<int64_t>(result));
+    }
+
+    BigInt result = 1;
+    for (size_t i = 0; i < exponent.limbs_.size(); ++i) {
+        uint32_t bits = exponent.limbs_[i];
+        bool last = i + 1 == exponent.limbs_.size();
+        for (int bit = 0; bit < 32 && (!last || bits); ++bit, bits >>= 1) {
+            if (bits & 1) {
+                DivMod(result * reduced, m, nullptr, &result);
+            }
+            DivMod(reduced * reduced, m, nullptr, &reduced);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Arbitrary precision integer: a sign and a magnitude of 32-bit limbs, least significant first,
+// without leading zero limbs. Zero has no limbs and is never negative.
+class BigInt {
+public:
+    BigInt() = default;
+    BigInt(int64_t value);
+
+    // Decimal with an optional sign, throws std::invalid_argument on anything else.
+    static BigInt FromString(std::string_view string);
+
+    bool IsZero() const;
+    bool IsNegative() const;
+    bool FitsInt64() const;
+    int64_t ToInt64() const;
+    std::string ToString() const;
+
+    BigInt operator-() const;
+    BigInt Abs() const;
+
+    friend BigInt operator+(const BigInt& a, const BigInt& b);
+    friend BigInt operator-(const BigInt& a, const BigInt& b);
+    // Karatsuba once both operands are long enough, schoolbook below that.
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+
+    // Truncates towards zero like C++, the remainder has the sign of the dividend.
+    // Throws std::domain_error when dividing by zero.
+    static void DivMod(const BigInt& a, const BigInt& b, BigInt* quotient, BigInt* remainder);
+
+    // -1, 0 or 1.
+    friend int Compare(const BigInt& a, const BigInt& b);
+
+    friend bool operator==(const BigInt& a, const BigInt& b) {
+        return Compare(a, b) == 0;
+    }
+
+    static BigInt Pow(const BigInt& base, uint64_t exponent);
+
+    // base^exponent mod modulus in [0, |modulus|), for a nonzero modulus.
+    static BigInt ModPow(const BigInt& base, const BigInt& exponent, const BigInt& modulus);
+
+private:
+    using Limbs = std::vector<uint32_t>;
+
+    BigInt(Limbs limbs, bool negative);
+
+    Limbs limbs_;
+    bool negative_ = false;
+};
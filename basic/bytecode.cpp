@@ -0,0 +1,1351 @@
+#include <bytecode.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <span>
+
+#include <collector.h>
+#include <error.h>
+#include <reclaimer.h>
+#include <scheme.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SCHEME_COMPUTED_GOTO
+#endif
+
+// Every instruction is an opcode word followed by its operands.
+enum class Op : uint32_t {
+    // constant: pushes constants[constant].
+    kConstant,
+    // slot: pushes a parameter or a variable of let.
+    kLocal,
+    // index: pushes a value captured by the running closure.
+    kCaptured,
+    // slot name: pushes what is defined in the slot of the environment, constants[name] if
+    // nothing is.
+    kGlobal,
+    // slot: pops into a variable of let.
+    kSetLocal,
+    // slot name: defines the top in the slot of the environment and replaces it by
+    // constants[name].
+    kDefine,
+    // lambda: pushes a new closure of lambdas[lambda].
+    kClosure,
+    kPop,
+    // Throws if the top is a cell. Lists of lists come only from quote.
+    kCheck,
+    // The same, unless the list evaluated last came from quote.
+    kCheckQuoted,
+    // quoted: the same in a list where a procedure may have been found at run time, which
+    // decides whether the element is the first one quote is applied to. Only looks at where
+    // the last list came from if quoted isn't 0.
+    kCheckApplied,
+    // quote: starts a list, see Reduce.
+    kBegin,
+    // function: starts a list of the arguments of functions[function].
+    kBeginCall,
+    // rest target head: if the top names a builtin, or is a closure and head isn't 0, pops
+    // it, and the elements after it are its arguments. And and or are applied to rests[rest]
+    // right away, which ends the list and jumps.
+    kDispatch,
+    // rest target: the same for the head of an expression, which has to be a procedure.
+    kHead,
+    // quoted: pops the tail and ends the list started last.
+    kEnd,
+    // count: puts a list of the count values below the top ending with the top in their place.
+    kList,
+    // function: replaces the top by functions[function] applied to it.
+    kCall,
+    // function count: replaces the count values on top by functions[function] called with
+    // them as its arguments.
+    kCallArguments,
+    // function rest: pushes functions[function] applied to rests[rest] as it is.
+    kCallRaw,
+    // target: keeps #f and jumps, pops anything else.
+    kAnd,
+    // target: pops #f, keeps anything else and jumps.
+    kOr,
+    // Throws if the top is the empty list.
+    kRequire,
+    // message
+    kRaise,
+    kReturn,
+};
+
+static constexpr const char* kMessages[] = {
+    "Invalid syntax",
+    "Invalid operands",
+    "Invalid operands, there should be a function first",
+};
+
+static constexpr uint32_t kInvalidSyntax = 0;
+static constexpr uint32_t kInvalidOperands = 1;
+static constexpr uint32_t kNoFunction = 2;
+
+static constexpr size_t kSmallFrame = 16;
+
+// The rest of a list as the tree walker gets it, for and and or.
+struct Rest {
+    Value tree;
+    // Nothing in it is a variable of a lambda or a special form, so unless it uses a defined
+    // variable the tree walker evaluates it like a program would.
+    bool closed;
+};
+
+// Code of a program or of one lambda in it.
+class Lambda {
+public:
+    std::vector<uint32_t> code;
+    std::vector<Value> constants;
+    std::vector<Function*> functions;
+    std::vector<Rest> rests;
+    std::vector<std::shared_ptr<const Lambda>> lambdas;
+    // Where a new closure takes each value it captures from, in the frame making it: a local
+    // slot, or with the lowest bit set the value captured by the running closure at index.
+    std::vector<uint32_t> captures;
+    uint32_t params = 0;
+    // Parameters first, then variables of let.
+    uint32_t locals = 0;
+    // The code jumps forward only, so the stack never holds more values than the code pushes.
+    size_t max_stack = 0;
+    Environment* environment = nullptr;
+};
+
+// RealCount's flag for the value of a list: whether it came straight from quote.
+enum class Quoted { NO, YES, MAYBE };
+
+struct Shape {
+    Quoted quoted = Quoted::NO;
+    // Always a cell, so it can't be a procedure.
+    bool list = false;
+};
+
+enum class Form { NONE, DEFINE, LAMBDA, LET };
+
+static Form FormOf(const std::string* name) {
+    static const std::string* const kDefine = Intern("define");
+    static const std::string* const kLambda = Intern("lambda");
+    static const std::string* const kLet = Intern("let");
+    if (name == kDefine) {
+        return Form::DEFINE;
+    }
+    if (name == kLambda) {
+        return Form::LAMBDA;
+    }
+    return name == kLet ? Form::LET : Form::NONE;
+}
+
+static Function* NamedFunction(const Value& value) {
+    if (!Is<Symbol>(value)) {
+        return nullptr;
+    }
+    return FunctionCreator(As<Symbol>(value));
+}
+
+static bool IsProperList(const Value& list) {
+    auto rest = &list;
+    while (Is<Cell>(*rest)) {
+        rest = &As<Cell>(*rest)->GetSecond();
+    }
+    return *rest == nullptr;
+}
+
+// Variables visible in the code of a lambda, or of the program.
+struct Scope {
+    Scope(Scope* parent, Lambda* lambda) : parent(parent), lambda(lambda){};
+
+    Scope* parent;
+    Lambda* lambda;
+    // Parameters and variables of let with their slots, innermost last.
+    std::vector<std::pair<const std::string*, uint32_t>> locals;
+    // Variables of enclosing lambdas used so far, by index in the closure.
+    std::vector<const std::string*> captured;
+};
+
+enum class Kind { LOCAL, CAPTURED, NONE };
+
+struct Variable {
+    Kind kind = Kind::NONE;
+    uint32_t index = 0;
+};
+
+static bool IsBound(const Scope* scope, const std::string* name) {
+    for (; scope; scope = scope->parent) {
+        for (const auto& local : scope->locals) {
+            if (local.first == name) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// A variable of an enclosing lambda is captured by every lambda in between, each closure
+// copies it from the frame that makes it.
+static Variable Lookup(Scope* scope, const std::string* name) {
+    for (auto it = scope->locals.rbegin(); it != scope->locals.rend(); ++it) {
+        if (it->first == name) {
+            return {Kind::LOCAL, it->second};
+        }
+    }
+    for (size_t i = 0; i < scope->captured.size(); ++i) {
+        if (scope->captured[i] == name) {
+            return {Kind::CAPTURED, static_cast<uint32_t>(i)};
+        }
+    }
+    if (!scope->parent) {
+        return {};
+    }
+    auto outer = Lookup(scope->parent, name);
+    if (outer.kind == Kind::NONE) {
+        return outer;
+    }
+    scope->lambda->captures.push_back(outer.index << 1 | (outer.kind == Kind::CAPTURED));
+    scope->captured.push_back(name);
+    return {Kind::CAPTURED, static_cast<uint32_t>(scope->captured.size() - 1)};
+}
+
+class Compiler {
+public:
+    Compiler(Lambda* lambda, Scope* scope, Environment* environment)
+        : lambda_(lambda), scope_(scope), environment_(environment){};
+
+    // Code for Count(tree).
+    void Count(const Value& tree) {
+        Expression(tree, true);
+        Emit(Op::kReturn);
+    }
+
+private:
+    void Expression(const Value& tree, bool top_level = false) {
+        if (tree == nullptr) {
+            Emit(Op::kRaise, kInvalidSyntax);
+            return;
+        }
+        if (!Is<Cell>(tree)) {
+            Atom(tree);
+            return;
+        }
+        auto pair = As<Cell>(tree);
+        const auto& head = pair->GetFirst();
+        if (auto form = FormOf(tree); form != Form::NONE) {
+            Special(form, pair->GetSecond(), top_level);
+        } else if (Is<Cell>(head)) {
+            List(head, false);
+            Head(pair->GetSecond());
+        } else if (auto func = Builtin(head)) {
+            Apply(As<Symbol>(head), func, pair->GetSecond());
+        } else if (IsVariable(head)) {
+            Atom(head);
+            Head(pair->GetSecond());
+        } else {
+            Emit(Op::kRaise, kNoFunction);
+        }
+    }
+
+    // Code for RealCount(list, isquote).first, which leaves the flag to the shape.
+    Shape List(const Value& list, bool isquote) {
+        if (auto form = FormOf(list); form != Form::NONE) {
+            Special(form, As<Cell>(list)->GetSecond(), false);
+            return {};
+        }
+        if (IsConstantList(list)) {
+            Emit(Op::kConstant, Constant(list));
+            return {Quoted::NO, true};
+        }
+        if (NeedsMarkers(list)) {
+            auto dynamic = !IsList(list);
+            Emit(Op::kBegin, isquote);
+            std::vector<size_t> ends;
+            Elements(list, isquote, true, true, &ends);
+            return {dynamic ? Quoted::MAYBE : Quoted::NO, !dynamic};
+        }
+        uint32_t count = 0;
+        auto cell = As<Cell>(list);
+        while (true) {
+            const auto& element = cell->GetFirst();
+            if (Is<Cell>(element)) {
+                auto inner = List(element, false);
+                if (!isquote || count > 0) {
+                    Check(inner.quoted);
+                }
+            } else if (auto func = Builtin(element)) {
+                Apply(As<Symbol>(element), func, cell->GetSecond());
+                if (count > 0) {
+                    Emit(Op::kList, count);
+                    return {Quoted::NO, true};
+                }
+                auto quoted = func->IsQuote() && !func->IsBoolean();
+                return {quoted ? Quoted::YES : Quoted::NO, false};
+            } else {
+                Atom(element);
+            }
+            ++count;
+            const auto& rest = cell->GetSecond();
+            if (!Is<Cell>(rest)) {
+                Emit(Op::kConstant, Constant(rest));
+                Emit(Op::kList, count);
+                return {Quoted::NO, true};
+            }
+            cell = As<Cell>(rest);
+        }
+    }
+
+    // Elements of a list after the kBegin, kBeginCall or kHead starting it, up to its kEnd.
+    // Until a procedure may have been found at run time, the code knows where each element
+    // is and whether quote is applied to them. A closure is applied only if it heads the list,
+    // anywhere else it is an argument. Jumps in ends go past the kEnd.
+    void Elements(const Value& list, bool isquote, bool known, bool head,
+                  std::vector<size_t>* ends) {
+        // Whether the rest after each element may be left to the tree walker, see Rest.
+        std::vector<const Cell*> cells;
+        for (auto rest = &list; Is<Cell>(*rest); rest = &As<Cell>(*rest)->GetSecond()) {
+            cells.push_back(As<Cell>(*rest));
+        }
+        std::vector<bool> closed(cells.size());
+        if (!cells.empty()) {
+            closed.back() = IsClosed(cells.back()->GetSecond());
+            for (size_t i = cells.size() - 1; i-- > 0;) {
+                closed[i] = closed[i + 1] && IsClosed(cells[i + 1]->GetFirst());
+            }
+        }
+
+        uint32_t count = 0;
+        for (size_t i = 0; i < cells.size(); ++i) {
+            const auto& element = cells[i]->GetFirst();
+            bool dynamic;
+            if (Is<Cell>(element)) {
+                auto inner = List(element, false);
+                if (!known) {
+                    if (inner.quoted != Quoted::YES) {
+                        Emit(Op::kCheckApplied, inner.quoted == Quoted::MAYBE);
+                    }
+                } else if (!isquote || count > 0) {
+                    Check(inner.quoted);
+                }
+                dynamic = !inner.list;
+            } else if (auto func = Builtin(element)) {
+                Apply(As<Symbol>(element), func, cells[i]->GetSecond());
+                Emit(Op::kEnd, func->IsQuote() && !func->IsBoolean());
+                Patch(*ends);
+                return;
+            } else {
+                dynamic = Atom(element);
+            }
+            if (dynamic) {
+                Emit(Op::kDispatch, AddRest(cells[i]->GetSecond(), closed[i]), 0,
+                     head && count == 0);
+                ends->push_back(lambda_->code.size() - 2);
+                known = false;
+            }
+            ++count;
+        }
+        Emit(Op::kConstant, Constant(cells.empty() ? list : cells.back()->GetSecond()));
+        Emit(Op::kEnd, 0);
+        Patch(*ends);
+    }
+
+    // Code applying the procedure on top to the rest, as Count does.
+    void Head(const Value& rest) {
+        Emit(Op::kHead, AddRest(rest, IsClosed(rest)), 0);
+        std::vector<size_t> ends = {lambda_->code.size() - 1};
+        Elements(rest, false, false, false, &ends);
+    }
+
+    // Code for ApplyFunction(func, rest).first.
+    void Apply(const Symbol* name, Function* func, const Value& rest) {
+        if (func->IsBoolean()) {
+            Boolean(name->GetName() == "and", func, rest);
+            return;
+        }
+        if (func->IsQuote() && Is<Cell>(rest) && As<Cell>(rest)->GetSecond() == nullptr) {
+            const auto& quoted = As<Cell>(rest)->GetFirst();
+            if (Is<Cell>(quoted) ? IsConstantList(quoted)
+                                 : !Builtin(quoted) && !IsVariable(quoted)) {
+                Emit(Op::kConstant, Constant(quoted));
+                return;
+            }
+        }
+        if (Is<Cell>(rest) && NeedsMarkers(rest)) {
+            Emit(Op::kBeginCall, AddFunction(func));
+            std::vector<size_t> ends;
+            Elements(rest, func->IsQuote(), true, false, &ends);
+            return;
+        }
+        if (func->IsArithmetic() && IsProperList(rest)) {
+            Arguments(func, rest);
+            return;
+        }
+        if (Is<Cell>(rest)) {
+            List(rest, func->IsQuote());
+        } else {
+            Emit(Op::kConstant, Constant(rest));
+        }
+        Emit(Op::kCall, AddFunction(func));
+    }
+
+    // Code for a call with a proper list of arguments, which stay on the stack.
+    void Arguments(Function* func, const Value& rest) {
+        for (auto list = &rest; *list != nullptr; list = &As<Cell>(*list)->GetSecond()) {
+            if (Builtin(As<Cell>(*list)->GetFirst())) {
+                List(rest, false);
+                Emit(Op::kCall, AddFunction(func));
+                return;
+            }
+        }
+        uint32_t count = 0;
+        for (auto list = &rest; *list != nullptr; list = &As<Cell>(*list)->GetSecond()) {
+            const auto& argument = As<Cell>(*list)->GetFirst();
+            if (Is<Cell>(argument)) {
+                Check(List(argument, false).quoted);
+            } else {
+                Atom(argument);
+            }
+            ++count;
+        }
+        Emit(Op::kCallArguments, AddFunction(func), count);
+    }
+
+    // And and or evaluate their arguments themselves, until one of them decides the answer.
+    void Boolean(bool conjunction, Function* func, const Value& rest) {
+        if (!Is<Cell>(rest)) {
+            Emit(Op::kConstant, Constant(Value::Boolean(conjunction)));
+            return;
+        }
+        if (!IsProperList(rest)) {
+            Emit(Op::kCallRaw, AddFunction(func), AddRest(rest, IsClosed(rest)));
+            return;
+        }
+        auto test = conjunction ? Op::kAnd : Op::kOr;
+        std::vector<size_t> exits;
+        auto cell = As<Cell>(rest);
+        while (true) {
+            const auto& argument = cell->GetFirst();
+            if (Is<Cell>(argument)) {
+                Check(List(argument, false).quoted);
+            } else {
+                Atom(argument);
+            }
+            if (cell->GetSecond() == nullptr) {
+                break;
+            }
+            Emit(test, 0);
+            exits.push_back(lambda_->code.size() - 1);
+            cell = As<Cell>(cell->GetSecond());
+        }
+        // Either gives the last argument as it is unless it's the empty list, so a call there
+        // is in tail position.
+        Emit(Op::kRequire);
+        Patch(exits);
+    }
+
+    void Special(Form form, const Value& rest, bool top_level) {
+        switch (form) {
+            case Form::DEFINE:
+                Define(rest, top_level);
+                break;
+            case Form::LAMBDA:
+                if (!Is<Cell>(rest)) {
+                    throw SyntaxError("Invalid syntax for lambda");
+                }
+                Procedure(As<Cell>(rest)->GetFirst(), As<Cell>(rest)->GetSecond(), "lambda");
+                break;
+            case Form::LET:
+                Let(rest);
+                break;
+            case Form::NONE:
+                break;
+        }
+    }
+
+    // (define name expression) or (define (name parameters...) body...), at the top level only.
+    void Define(const Value& rest, bool top_level) {
+        if (!top_level || !environment_ || !Is<Cell>(rest)) {
+            throw SyntaxError("Invalid syntax for define");
+        }
+        auto pair = As<Cell>(rest);
+        Value name;
+        if (Is<Cell>(pair->GetFirst())) {
+            auto signature = As<Cell>(pair->GetFirst());
+            name = signature->GetFirst();
+            CheckName(name, "define");
+            CheckDefinable(name);
+            Procedure(signature->GetSecond(), pair->GetSecond(), "define");
+        } else {
+            name = pair->GetFirst();
+            CheckName(name, "define");
+            CheckDefinable(name);
+            if (!Is<Cell>(pair->GetSecond()) ||
+                As<Cell>(pair->GetSecond())->GetSecond() != nullptr) {
+                throw SyntaxError("Invalid syntax for define");
+            }
+            Expression(As<Cell>(pair->GetSecond())->GetFirst());
+        }
+        Emit(Op::kDefine, environment_->GetSlot(As<Symbol>(name)->GetInterned()),
+             Constant(name));
+    }
+
+    // Compiles the body into a lambda of its own, and here the code making its closures.
+    void Procedure(const Value& parameters, const Value& body, const char* form) {
+        auto lambda = std::make_shared<Lambda>();
+        lambda->environment = environment_;
+        Scope scope{scope_, lambda.get()};
+        for (auto rest = &parameters; *rest != nullptr; rest = &As<Cell>(*rest)->GetSecond()) {
+            if (!Is<Cell>(*rest)) {
+                throw SyntaxError(std::string("Invalid syntax for ") + form);
+            }
+            const auto& parameter = As<Cell>(*rest)->GetFirst();
+            CheckName(parameter, form);
+            auto name = As<Symbol>(parameter)->GetInterned();
+            for (const auto& local : scope.locals) {
+                if (local.first == name) {
+                    throw SyntaxError(std::string("Invalid syntax for ") + form);
+                }
+            }
+            scope.locals.emplace_back(name, lambda->params++);
+        }
+        lambda->locals = lambda->params;
+        Compiler compiler{lambda.get(), &scope, environment_};
+        compiler.Body(body, form);
+        compiler.Emit(Op::kReturn);
+        lambda_->lambdas.push_back(std::move(lambda));
+        Emit(Op::kClosure, lambda_->lambdas.size() - 1);
+    }
+
+    // (let ((name expression)...) body...): the expressions see the variables outside only.
+    void Let(const Value& rest) {
+        if (!Is<Cell>(rest)) {
+            throw SyntaxError("Invalid syntax for let");
+        }
+        std::vector<const std::string*> names;
+        for (auto list = &As<Cell>(rest)->GetFirst(); *list != nullptr;
+             list = &As<Cell>(*list)->GetSecond()) {
+            if (!Is<Cell>(*list)) {
+                throw SyntaxError("Invalid syntax for let");
+            }
+            const auto& binding = As<Cell>(*list)->GetFirst();
+            if (!Is<Cell>(binding) || !Is<Cell>(As<Cell>(binding)->GetSecond()) ||
+                As<Cell>(As<Cell>(binding)->GetSecond())->GetSecond() != nullptr) {
+                throw SyntaxError("Invalid syntax for let");
+            }
+            CheckName(As<Cell>(binding)->GetFirst(), "let");
+            auto name = As<Symbol>(As<Cell>(binding)->GetFirst())->GetInterned();
+            if (std::find(names.begin(), names.end(), name) != names.end()) {
+                throw SyntaxError("Invalid syntax for let");
+            }
+            names.push_back(name);
+            Expression(As<Cell>(As<Cell>(binding)->GetSecond())->GetFirst());
+        }
+        auto base = static_cast<uint32_t>(scope_->locals.size());
+        for (auto i = static_cast<uint32_t>(names.size()); i-- > 0;) {
+            Emit(Op::kSetLocal, base + i);
+        }
+        for (uint32_t i = 0; i < names.size(); ++i) {
+            scope_->locals.emplace_back(names[i], base + i);
+        }
+        lambda_->locals = std::max<uint32_t>(lambda_->locals, scope_->locals.size());
+        Body(As<Cell>(rest)->GetSecond(), "let");
+        scope_->locals.resize(base);
+    }
+
+    // Expressions evaluated one after another, the value of the last one is kept.
+    void Body(const Value& body, const char* form) {
+        if (!Is<Cell>(body) || !IsProperList(body)) {
+            throw SyntaxError(std::string("Invalid syntax for ") + form);
+        }
+        for (auto rest = &body; *rest != nullptr; rest = &As<Cell>(*rest)->GetSecond()) {
+            if (rest != &body) {
+                Emit(Op::kPop);
+            }
+            Expression(As<Cell>(*rest)->GetFirst());
+        }
+    }
+
+    // Programs are compiled knowing what the builtins are, those stay.
+    static void CheckDefinable(const Value& name) {
+        if (FunctionCreator(As<Symbol>(name))) {
+            throw SyntaxError("Invalid syntax for define");
+        }
+    }
+
+    // Special forms can't be variables, builtins may be shadowed by local ones.
+    static void CheckName(const Value& name, const char* form) {
+        if (!Is<Symbol>(name) || ::FormOf(As<Symbol>(name)->GetInterned()) != Form::NONE) {
+            throw SyntaxError(std::string("Invalid syntax for ") + form);
+        }
+    }
+
+    Form FormOf(const Value& list) const {
+        const auto& head = As<Cell>(list)->GetFirst();
+        if (!Is<Symbol>(head) || IsBound(scope_, As<Symbol>(head)->GetInterned())) {
+            return Form::NONE;
+        }
+        return ::FormOf(As<Symbol>(head)->GetInterned());
+    }
+
+    // The builtin an unevaluated atom names, unless a variable shadows it.
+    Function* Builtin(const Value& atom) const {
+        if (!Is<Symbol>(atom) || IsBound(scope_, As<Symbol>(atom)->GetInterned())) {
+            return nullptr;
+        }
+        return FunctionCreator(As<Symbol>(atom));
+    }
+
+    bool IsVariable(const Value& atom) const {
+        if (!Is<Symbol>(atom)) {
+            return false;
+        }
+        auto name = As<Symbol>(atom)->GetInterned();
+        if (IsBound(scope_, name)) {
+            return true;
+        }
+        if (!environment_ || ::FormOf(name) != Form::NONE || FunctionCreator(As<Symbol>(atom))) {
+            return false;
+        }
+        // Lambdas may be called after anything is defined.
+        return scope_->parent || environment_->IsDefined(name);
+    }
+
+    // Code pushing the value of an atom. Returns whether it's a variable, which may hold a
+    // procedure.
+    bool Atom(const Value& atom) {
+        if (IsVariable(atom)) {
+            auto variable = Lookup(scope_, As<Symbol>(atom)->GetInterned());
+            if (variable.kind == Kind::LOCAL) {
+                Emit(Op::kLocal, variable.index);
+            } else if (variable.kind == Kind::CAPTURED) {
+                Emit(Op::kCaptured, variable.index);
+            } else {
+                Emit(Op::kGlobal, environment_->GetSlot(As<Symbol>(atom)->GetInterned()),
+                     Constant(atom));
+            }
+            return true;
+        }
+        Emit(Op::kConstant, Constant(atom));
+        return false;
+    }
+
+    // Nothing in the list is evaluated to anything but itself, so it is its own value.
+    bool IsConstantList(const Value& list) const {
+        auto rest = &list;
+        while (Is<Cell>(*rest)) {
+            const auto& element = As<Cell>(*rest)->GetFirst();
+            if (Is<Cell>(element) || Builtin(element) || IsVariable(element)) {
+                return false;
+            }
+            rest = &As<Cell>(*rest)->GetSecond();
+        }
+        return true;
+    }
+
+    // Whether List gives the list a shape with list set, without compiling it.
+    bool IsList(const Value& list) const {
+        if (FormOf(list) != Form::NONE) {
+            return false;
+        }
+        if (IsConstantList(list)) {
+            return true;
+        }
+        const auto& first = As<Cell>(list)->GetFirst();
+        if (Is<Cell>(first)) {
+            return IsList(first);
+        }
+        return !Builtin(first) && !IsVariable(first);
+    }
+
+    // Whether an element evaluated as the list is may turn out to be a procedure.
+    bool NeedsMarkers(const Value& list) const {
+        for (auto rest = &list; Is<Cell>(*rest); rest = &As<Cell>(*rest)->GetSecond()) {
+            const auto& element = As<Cell>(*rest)->GetFirst();
+            if (Is<Cell>(element) ? !IsList(element) : IsVariable(element)) {
+                return true;
+            }
+            if (Builtin(element)) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool IsClosed(const Value& tree) const {
+        auto rest = &tree;
+        while (Is<Cell>(*rest)) {
+            if (FormOf(*rest) != Form::NONE || !IsClosed(As<Cell>(*rest)->GetFirst())) {
+                return false;
+            }
+            rest = &As<Cell>(*rest)->GetSecond();
+        }
+        return !Is<Symbol>(*rest) || !IsBound(scope_, As<Symbol>(*rest)->GetInterned());
+    }
+
+    void Check(Quoted quoted) {
+        if (quoted == Quoted::NO) {
+            Emit(Op::kCheck);
+        } else if (quoted == Quoted::MAYBE) {
+            Emit(Op::kCheckQuoted);
+        }
+    }
+
+    template <class... Operands>
+    void Emit(Op op, Operands... operands) {
+        switch (op) {
+            case Op::kConstant:
+            case Op::kLocal:
+            case Op::kCaptured:
+            case Op::kGlobal:
+            case Op::kClosure:
+            case Op::kCallRaw:
+                ++lambda_->max_stack;
+                break;
+            default:
+                break;
+        }
+        lambda_->code.push_back(static_cast<uint32_t>(op));
+        (lambda_->code.push_back(operands), ...);
+    }
+
+    // Jumps to the end of the code so far.
+    void Patch(const std::vector<size_t>& targets) {
+        for (auto target : targets) {
+            lambda_->code[target] = lambda_->code.size();
+        }
+    }
+
+    uint32_t Constant(const Value& value) {
+        lambda_->constants.push_back(value);
+        return lambda_->constants.size() - 1;
+    }
+
+    uint32_t AddFunction(Function* func) {
+        lambda_->functions.push_back(func);
+        return lambda_->functions.size() - 1;
+    }
+
+    uint32_t AddRest(const Value& tree, bool closed) {
+        lambda_->rests.push_back({tree, closed});
+        return lambda_->rests.size() - 1;
+    }
+
+    Lambda* lambda_;
+    Scope* scope_;
+    Environment* environment_;
+};
+
+Environment::~Environment() {
+    if (collector_) {
+        for (auto& global : globals_) {
+            collector_->RemoveRoot(&global.value);
+        }
+    }
+    if (reclaimer_) {
+        for (auto& global : globals_) {
+            reclaimer_->Retire(std::move(global.value));
+        }
+    }
+}
+
+uint32_t Environment::GetSlot(const std::string* name) {
+    auto [it, inserted] = slots_.emplace(name, globals_.size());
+    if (inserted) {
+        globals_.emplace_back();
+        if (collector_) {
+            collector_->AddRoot(&globals_.back().value);
+        }
+    }
+    return it->second;
+}
+
+void Environment::Define(uint32_t slot, Value value) {
+    if (!collector_) {
+        ArenaScope heap{nullptr};
+        CollectorScope untracked{nullptr};
+        value = CopyToHeap(value);
+    }
+    auto& global = globals_[slot];
+    if (reclaimer_) {
+        reclaimer_->Retire(std::move(global.value));
+    }
+    global.value = std::move(value);
+    if (!global.defined) {
+        global.defined = true;
+        ++defined_count_;
+    }
+}
+
+bool Environment::IsDefined(const std::string* name) const {
+    auto it = slots_.find(name);
+    return it != slots_.end() && globals_[it->second].defined;
+}
+
+void Environment::SetCollector(Collector* collector) {
+    collector_ = collector;
+    for (auto& global : globals_) {
+        collector_->AddRoot(&global.value);
+    }
+}
+
+void Environment::SetReclaimer(Reclaimer* reclaimer) {
+    reclaimer_ = reclaimer;
+}
+
+bool Environment::Defines(const Value& tree) const {
+    auto rest = &tree;
+    while (Is<Cell>(*rest)) {
+        if (Defines(As<Cell>(*rest)->GetFirst())) {
+            return true;
+        }
+        rest = &As<Cell>(*rest)->GetSecond();
+    }
+    if (!Is<Symbol>(*rest)) {
+        return false;
+    }
+    return IsDefined(As<Symbol>(*rest)->GetInterned());
+}
+
+// Whether the compiler, or the tree walker given a rest of it, would recurse deeper than limit:
+// once into every list in a list, and once into the rest after a builtin. Doesn't recurse itself.
+static bool IsNestedDeeper(const Value& tree, size_t limit) {
+    std::vector<std::pair<const Value*, size_t>> lists;
+    if (Is<Cell>(tree)) {
+        lists.emplace_back(&tree, 1);
+    }
+    while (!lists.empty()) {
+        auto [rest, depth] = lists.back();
+        lists.pop_back();
+        if (depth > limit) {
+            return true;
+        }
+        for (; Is<Cell>(*rest); rest = &As<Cell>(*rest)->GetSecond()) {
+            const auto& element = As<Cell>(*rest)->GetFirst();
+            if (Is<Cell>(element)) {
+                lists.emplace_back(&element, depth + 1);
+            } else if (NamedFunction(element) && ++depth > limit) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+Program::Program(const Value& tree, Environment* environment) {
+    if (IsNestedDeeper(tree, kMaxNesting)) {
+        throw RuntimeError("Nesting is too deep");
+    }
+    auto lambda = std::make_shared<Lambda>();
+    lambda->environment = environment;
+    Scope scope{nullptr, lambda.get()};
+    Compiler{lambda.get(), &scope, environment}.Count(tree);
+    main_ = std::move(lambda);
+}
+
+size_t Program::GetCodeSize() const {
+    return main_->code.size();
+}
+
+// A procedure found in a list, to be applied to what follows it once the list is done. One
+// without a procedure starts a list, quote says whether quote is applied to it.
+struct Marker {
+    Value* base;
+    Function* func;
+    Value closure;
+    bool quote;
+};
+
+// What the code after a call in tail position would have checked of the value it returns.
+static constexpr uint32_t kNotList = 1;
+static constexpr uint32_t kNotEmpty = 2;
+
+// A call waiting for the one it made to return.
+struct Frame {
+    const Lambda* lambda;
+    // Keeps the lambda and what it captured alive, nullptr for the program.
+    Value closure;
+    // Where the code goes on once the list that made the call is done.
+    const uint32_t* pc;
+    Value* locals;
+    Value* top;
+    // Markers below this one belong to the frames below.
+    size_t markers;
+    uint32_t checks;
+};
+
+// Local slots and stacks of the frames of a run, in blocks that never move, so that frames and
+// markers may point into them. Most runs need nothing but the first one.
+class ValueStack {
+public:
+    ValueStack() {
+        first_.values = small_.data();
+        first_.size = small_.size();
+    };
+
+    ValueStack(const ValueStack&) = delete;
+    ValueStack& operator=(const ValueStack&) = delete;
+
+    // size empty values after the ones pushed so far.
+    Value* Push(size_t size) {
+        auto block = &GetBlock(current_);
+        if (block->size - block->used < size) {
+            if (++current_ > blocks_.size()) {
+                blocks_.emplace_back();
+            }
+            block = &GetBlock(current_);
+            if (block->size < size) {
+                block->size = std::max(size, kBlockSize);
+                block->owned = std::make_unique<Value[]>(block->size);
+                block->values = block->owned.get();
+            }
+        }
+        auto values = block->values + block->used;
+        block->used += size;
+        return values;
+    };
+
+    // Takes back the values pushed last, which have to be empty again.
+    void Pop(size_t size) {
+        auto& block = GetBlock(current_);
+        block.used -= size;
+        if (block.used == 0 && current_ > 0) {
+            --current_;
+        }
+    };
+
+    // Every value pushed and not taken back yet.
+    template <class Visit>
+    void ForEach(Visit visit) {
+        for (size_t i = 0; i <= current_; ++i) {
+            auto& block = GetBlock(i);
+            std::for_each(block.values, block.values + block.used, visit);
+        }
+    };
+
+private:
+    struct Block {
+        Value* values = nullptr;
+        size_t size = 0;
+        size_t used = 0;
+        std::unique_ptr<Value[]> owned;
+    };
+
+    static constexpr size_t kBlockSize = 256;
+
+    Block& GetBlock(size_t index) {
+        return index == 0 ? first_ : blocks_[index - 1];
+    };
+
+    std::array<Value, kSmallFrame> small_;
+    Block first_;
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+};
+
+// The tree walker knows no variables, only a rest using none of them can be left to it.
+static const Value& Unevaluated(const Lambda& lambda, const Rest& rest) {
+    if (!rest.closed || (lambda.environment && lambda.environment->Defines(rest.tree))) {
+        throw RuntimeError(kMessages[kInvalidSyntax]);
+    }
+    return rest.tree;
+}
+
+// Ends the list started last with the tail on top. Going back from the last marker, what was
+// pushed after it ending with the rest of the list so far is what its procedure is applied to,
+// and the result is the rest of the list before it. Returns the new top.
+//
+// A closure isn't called here: it is moved into callee with its arguments moved into
+// arguments, and the list goes on from the value the call pushes when it returns.
+static Value* Reduce(Value* top, std::vector<Marker>* markers, bool* quoted, Value* callee,
+                     std::vector<Value>* arguments) {
+    Value rest = std::move(*--top);
+    while (true) {
+        auto& marker = markers->back();
+        auto elements = std::span(marker.base, top - marker.base);
+        top = marker.base;
+        if (!marker.func && marker.closure == nullptr) {
+            if (!elements.empty()) {
+                rest = NewList(elements, std::move(rest));
+                *quoted = false;
+            }
+            markers->pop_back();
+            break;
+        }
+        if (marker.closure != nullptr) {
+            for (auto& element : elements) {
+                arguments->push_back(std::move(element));
+            }
+            const Value* list = &rest;
+            for (; Is<Cell>(*list); list = &As<Cell>(*list)->GetSecond()) {
+                arguments->push_back(As<Cell>(*list)->GetFirst());
+            }
+            if (*list != nullptr) {
+                throw RuntimeError(kMessages[kInvalidOperands]);
+            }
+            *callee = std::move(marker.closure);
+            *quoted = marker.quote;
+            markers->pop_back();
+            return top;
+        }
+        Value result;
+        if (rest == nullptr && !elements.empty() && marker.func->IsArithmetic()) {
+            result = marker.func->Call(elements);
+            for (auto& element : elements) {
+                element = nullptr;
+            }
+        } else {
+            auto list = elements.empty() ? std::move(rest) : NewList(elements, std::move(rest));
+            result = marker.func->Do(list);
+        }
+        rest = std::move(result);
+        *quoted = marker.quote;
+        markers->pop_back();
+    }
+    *top++ = std::move(rest);
+    return top;
+}
+
+// Whether the code at pc does nothing but check the value on top and return it. The checks
+// are added to checks.
+static bool IsTail(const uint32_t* pc, uint32_t* checks) {
+    while (true) {
+        switch (static_cast<Op>(*pc++)) {
+            case Op::kCheck:
+            case Op::kCheckQuoted:
+                // A procedure returned the value, so it didn't come from quote.
+                *checks |= kNotList;
+                break;
+            case Op::kRequire:
+                *checks |= kNotEmpty;
+                break;
+            case Op::kReturn:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+// A safe point of the collector: everything the run holds is in its stack, frames and markers.
+static void CollectYoung(Collector* collector, ValueStack* values, std::vector<Frame>* frames,
+                         std::vector<Marker>* markers, Value* self) {
+    std::vector<Value*> roots{self};
+    values->ForEach([&roots](Value& value) { roots.push_back(&value); });
+    for (auto& frame : *frames) {
+        roots.push_back(&frame.closure);
+    }
+    for (auto& marker : *markers) {
+        roots.push_back(&marker.closure);
+    }
+    collector->Minor(roots);
+}
+
+static Value Execute(const Lambda& program, size_t max_depth);
+
+Value Program::Run(size_t max_depth) const {
+    return Execute(*main_, max_depth);
+}
+
+// Each instruction jumps straight to the next one's code, with a switch in a loop elsewhere.
+#ifdef SCHEME_COMPUTED_GOTO
+#define SCHEME_OP(op) op:
+#define SCHEME_NEXT() goto* kTargets[*pc++]
+#else
+#define SCHEME_OP(op) case Op::op:
+#define SCHEME_NEXT() continue
+#endif
+
+// Calls don't recurse here: the caller's frame is pushed onto frames and the callee runs in
+// the same loop, until it returns into the list that made the call.
+static Value Execute(const Lambda& program, size_t max_depth) {
+#ifdef SCHEME_COMPUTED_GOTO
+    // In the order of Op.
+    static const void* const kTargets[] = {
+        &&kConstant, &&kLocal, &&kCaptured, &&kGlobal, &&kSetLocal, &&kDefine, &&kClosure,
+        &&kPop, &&kCheck, &&kCheckQuoted, &&kCheckApplied, &&kBegin, &&kBeginCall,
+        &&kDispatch, &&kHead, &&kEnd, &&kList, &&kCall, &&kCallArguments, &&kCallRaw,
+        &&kAnd, &&kOr, &&kRequire, &&kRaise, &&kReturn,
+    };
+#endif
+    ValueStack values;
+    std::vector<Frame> frames;
+    std::vector<Marker> markers;
+    // Of the closure about to be called.
+    std::vector<Value> arguments;
+    // Whose nursery is emptied at calls once it is full.
+    Collector* collector = GetCurrentArena() ? nullptr : GetCurrentCollector();
+
+    // The running frame: local slots and then the stack.
+    const Lambda* lambda = &program;
+    Value self;
+    const Closure* closure = nullptr;
+    auto locals = values.Push(lambda->locals + lambda->max_stack);
+    // Everything at and above top is empty.
+    auto top = locals + lambda->locals;
+    auto code = lambda->code.data();
+    auto pc = code;
+    auto constants = lambda->constants.data();
+    size_t marker_base = 0;
+    // Left by the frames this one took the place of.
+    uint32_t checks = 0;
+    // RealCount's flag for the list evaluated last, when the code can't know it.
+    bool quoted = false;
+
+#ifdef SCHEME_COMPUTED_GOTO
+    SCHEME_NEXT();
+#else
+    while (true)
+        switch (static_cast<Op>(*pc++))
+#endif
+    {
+        SCHEME_OP(kConstant) {
+            *top++ = constants[*pc++];
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kLocal) {
+            *top++ = locals[*pc++];
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kCaptured) {
+            *top++ = closure->GetCaptured()[*pc++];
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kGlobal) {
+            auto global = lambda->environment->Find(pc[0]);
+            *top++ = global ? *global : constants[pc[1]];
+            pc += 2;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kSetLocal) {
+            locals[*pc++] = std::move(*--top);
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kDefine) {
+            lambda->environment->Define(pc[0], std::move(top[-1]));
+            top[-1] = constants[pc[1]];
+            pc += 2;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kClosure) {
+            const auto& made = lambda->lambdas[*pc++];
+            std::vector<Value> captured;
+            captured.reserve(made->captures.size());
+            for (auto from : made->captures) {
+                captured.push_back(from & 1 ? closure->GetCaptured()[from >> 1]
+                                            : locals[from >> 1]);
+            }
+            *top++ = New<Closure>(made, std::move(captured));
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kPop) {
+            *--top = nullptr;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kCheck) {
+            if (Is<Cell>(top[-1])) {
+                throw RuntimeError(kMessages[kInvalidSyntax]);
+            }
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kCheckQuoted) {
+            if (!quoted && Is<Cell>(top[-1])) {
+                throw RuntimeError(kMessages[kInvalidSyntax]);
+            }
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kCheckApplied) {
+            const auto& marker = markers.back();
+            if (Is<Cell>(top[-1]) && !(*pc && quoted) &&
+                !(marker.quote && top - 1 == marker.base)) {
+                throw RuntimeError(kMessages[kInvalidSyntax]);
+            }
+            ++pc;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kBegin) {
+            markers.push_back({top, nullptr, nullptr, *pc++ != 0});
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kBeginCall) {
+            auto func = lambda->functions[*pc++];
+            markers.push_back({top, nullptr, nullptr, false});
+            markers.push_back({top, func, nullptr, func->IsQuote()});
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kDispatch) {
+            auto func = NamedFunction(top[-1]);
+            if (!func && !(pc[2] && Is<Closure>(top[-1]))) {
+                pc += 3;
+                SCHEME_NEXT();
+            }
+            if (func && func->IsBoolean()) {
+                top[-1] = func->Do(Unevaluated(*lambda, lambda->rests[pc[0]]));
+                quoted = false;
+                pc = code + pc[1];
+                goto reduce;
+            }
+            --top;
+            markers.push_back(
+                {top, func, func ? nullptr : std::move(*top), func && func->IsQuote()});
+            *top = nullptr;
+            pc += 3;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kHead) {
+            auto func = NamedFunction(top[-1]);
+            if (!func && !Is<Closure>(top[-1])) {
+                throw RuntimeError(kMessages[kNoFunction]);
+            }
+            if (func && func->IsBoolean()) {
+                top[-1] = func->Do(Unevaluated(*lambda, lambda->rests[pc[0]]));
+                pc = code + pc[1];
+                SCHEME_NEXT();
+            }
+            --top;
+            markers.push_back({top, nullptr, nullptr, false});
+            markers.push_back(
+                {top, func, func ? nullptr : std::move(*top), func && func->IsQuote()});
+            *top = nullptr;
+            pc += 2;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kEnd) {
+            quoted = *pc++ != 0;
+            goto reduce;
+        }
+        SCHEME_OP(kList) {
+            auto count = *pc++;
+            auto tail = std::move(*--top);
+            top -= count;
+            auto list = NewList(std::span(top, count), std::move(tail));
+            *top++ = std::move(list);
+            quoted = false;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kCall) {
+            top[-1] = lambda->functions[*pc++]->Do(top[-1]);
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kCallArguments) {
+            auto count = pc[1];
+            auto args = std::span(top - count, count);
+            auto result = lambda->functions[pc[0]]->Call(args);
+            for (auto& arg : args) {
+                arg = nullptr;
+            }
+            top -= count;
+            *top++ = std::move(result);
+            pc += 2;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kCallRaw) {
+            *top++ = lambda->functions[pc[0]]->Do(Unevaluated(*lambda, lambda->rests[pc[1]]));
+            pc += 2;
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kAnd) {
+            if (top[-1] == nullptr) {
+                throw RuntimeError(kMessages[kInvalidOperands]);
+            }
+            if (top[-1].IsFalse()) {
+                pc = code + *pc;
+            } else {
+                *--top = nullptr;
+                ++pc;
+            }
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kOr) {
+            if (top[-1] == nullptr) {
+                throw RuntimeError(kMessages[kInvalidOperands]);
+            }
+            if (top[-1].IsFalse()) {
+                *--top = nullptr;
+                ++pc;
+            } else {
+                pc = code + *pc;
+            }
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kRequire) {
+            if (top[-1] == nullptr) {
+                throw RuntimeError(kMessages[kInvalidOperands]);
+            }
+            SCHEME_NEXT();
+        }
+        SCHEME_OP(kRaise) {
+            throw RuntimeError(kMessages[*pc]);
+        }
+        SCHEME_OP(kReturn) {
+            auto result = std::move(top[-1]);
+            if ((checks & kNotList) && Is<Cell>(result)) {
+                throw RuntimeError(kMessages[kInvalidSyntax]);
+            }
+            if ((checks & kNotEmpty) && result == nullptr) {
+                throw RuntimeError(kMessages[kInvalidOperands]);
+            }
+            if (frames.empty()) {
+                return result;
+            }
+            std::fill(locals, top, nullptr);
+            values.Pop(lambda->locals + lambda->max_stack);
+            auto& caller = frames.back();
+            lambda = caller.lambda;
+            self = std::move(caller.closure);
+            closure = self == nullptr ? nullptr : As<Closure>(self);
+            pc = caller.pc;
+            locals = caller.locals;
+            top = caller.top;
+            marker_base = caller.markers;
+            checks = caller.checks;
+            frames.pop_back();
+            code = lambda->code.data();
+            constants = lambda->constants.data();
+            *top++ = std::move(result);
+            quoted = false;
+            goto reduce;
+        }
+    reduce : {
+        Value callee;
+        top = Reduce(top, &markers, &quoted, &callee, &arguments);
+        if (callee == nullptr) {
+            SCHEME_NEXT();
+        }
+        const auto& next = *As<Closure>(callee)->GetLambda();
+        if (arguments.size() != next.params) {
+            throw RuntimeError("Wrong number of arguments");
+        }
+        auto tail_checks = checks;
+        if (markers.size() == marker_base + 1 && markers.back().base == top &&
+            IsTail(pc, &tail_checks)) {
+            // All that is left of this frame is returning what the call returns, so the
+            // callee takes its place and runs in constant space however deep it recurses.
+            markers.pop_back();
+            std::fill(locals, top, nullptr);
+            values.Pop(lambda->locals + lambda->max_stack);
+            checks = tail_checks;
+        } else {
+            if (frames.size() == max_depth) {
+                throw RuntimeError("Recursion is too deep");
+            }
+            frames.push_back({lambda, std::move(self), pc, locals, top, marker_base, checks});
+            marker_base = markers.size();
+            checks = 0;
+        }
+        self = std::move(callee);
+        closure = As<Closure>(self);
+        lambda = &next;
+        locals = values.Push(lambda->locals + lambda->max_stack);
+        std::move(arguments.begin(), arguments.end(), locals);
+        arguments.clear();
+        top = locals + lambda->locals;
+        code = pc = lambda->code.data();
+        constants = lambda->constants.data();
+        if (collector && collector->IsNurseryFull()) {
+            CollectYoung(collector, &values, &frames, &markers, &self);
+            closure = As<Closure>(self);
+        }
+        SCHEME_NEXT();
+    }
+    }
+#ifndef SCHEME_COMPUTED_GOTO
+    return nullptr;
+#endif
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <object.h>
+
+class Function;
+class Reclaimer;
+
+// Variables defined at the top level, kept between runs. Code refers to them by slot: a slot
+// is given to a name the first time code using it is compiled and stays the same after that,
+// so the code stays right whatever is defined later.
+class Environment {
+public:
+    Environment() = default;
+
+    Environment(const Environment&) = delete;
+    Environment& operator=(const Environment&) = delete;
+
+    ~Environment();
+
+    uint32_t GetSlot(const std::string* name);
+
+    // nullptr while nothing is defined in the slot.
+    const Value* Find(uint32_t slot) const {
+        const auto& global = globals_[slot];
+        return global.defined ? &global.value : nullptr;
+    };
+
+    // Anything in an arena is copied out of it, definitions outlive the run.
+    void Define(uint32_t slot, Value value);
+
+    bool IsDefined(const std::string* name) const;
+
+    // Whether a symbol anywhere in the tree names something defined.
+    bool Defines(const Value& tree) const;
+
+    // Names defined so far. Code at the top level compiled before a name was defined takes
+    // it for a constant.
+    size_t GetDefinedCount() const {
+        return defined_count_;
+    };
+
+    // Every slot is a root of the collector from now on.
+    void SetCollector(Collector* collector);
+
+    // Values that are defined over or go with the environment are retired to it from now on.
+    void SetReclaimer(Reclaimer* reclaimer);
+
+private:
+    struct Global {
+        Value value;
+        bool defined = false;
+    };
+
+    std::unordered_map<const std::string*, uint32_t> slots_;
+    // Roots have to stay where they are.
+    std::deque<Global> globals_;
+    Collector* collector_ = nullptr;
+    Reclaimer* reclaimer_ = nullptr;
+    size_t defined_count_ = 0;
+};
+
+// An expression compiled into code for a small stack machine. Count and RealCount decide on
+// every evaluation what each node of the tree means: whether a symbol names a builtin, where
+// a function is applied to the rest of a list, which lists only hold constants. A program
+// decides that once, so it gives exactly the answers and errors Count does.
+//
+// Programs also know define, lambda and let, which the tree walker doesn't. Every variable is
+// resolved when the code is compiled: parameters and variables of let are slots of the frame
+// of a call, variables of enclosing lambdas are copied into the closure when it is made, and
+// anything else is a slot of the environment. A symbol that names no variable still evaluates
+// to itself, outside of lambdas it is compiled as a constant unless something is defined by its
+// name already. A closure is applied where it heads a list and is passed on as a value anywhere
+// else, while values naming a builtin are applied to the rest of the list wherever they turn
+// up, as the builtins named in it are. Only and and or take their arguments unevaluated: where
+// the code can't be compiled for them, those are handed to the tree walker and may not use
+// variables.
+//
+// Calls don't take the C++ stack: frames live on a stack of their own on the heap, and a call
+// that is the last thing its caller does, checks of the value aside, takes the caller's place.
+// Recursion in tail position leaves no frames behind, any other is limited by the depth a run
+// is given. What the calls allocate is another matter: it stays in the arena until the run is
+// over, only a collector takes it back during the run. Compiling still recurses into nested
+// lists, so the tree may only be nested so deep.
+//
+// A program holds references into its tree, which nothing ever changes, so it may be run any
+// number of times. The tree has to be on the heap, not in an arena reset in the meantime.
+class Program {
+public:
+    // Calls waiting for the ones they made to return.
+    static constexpr size_t kDefaultMaxDepth = 100000;
+    // Lists in lists, counting the rest after a builtin found in a list as one more.
+    static constexpr size_t kMaxNesting = 1000;
+
+    // Without an environment nothing can be defined and every symbol is a constant. Throws
+    // RuntimeError for a tree nested deeper than kMaxNesting.
+    explicit Program(const Value& tree, Environment* environment = nullptr);
+
+    // Same as Count(tree). Throws RuntimeError when more than max_depth calls would wait.
+    Value Run(size_t max_depth = kDefaultMaxDepth) const;
+
+    size_t GetCodeSize() const;
+
+private:
+    std::shared_ptr<const Lambda> main_;
+};
@@ -0,0 +1,167 @@
+#include <char_scan.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCHEME_SCAN_X86
+#endif
+
+template <int kClass>
+static const char* SkipScalar(const char* begin, const char* end) {
+    while (begin != end && (kCharClasses[static_cast<unsigned char>(*begin)] & kClass)) {
+        ++begin;
+    }
+    return begin;
+}
+
+#ifdef SCHEME_SCAN_X86
+
+// x <= bound for unsigned bytes: saturating subtraction leaves zero exactly then.
+__attribute__((target("sse2"))) static inline __m128i LessEqualSse2(__m128i x, char bound) {
+    return _mm_cmpeq_epi8(_mm_subs_epu8(x, _mm_set1_epi8(bound)), _mm_setzero_si128());
+}
+
+__attribute__((target("sse2"))) static inline __m128i InRangeSse2(__m128i x, char lo, char hi) {
+    return LessEqualSse2(_mm_sub_epi8(x, _mm_set1_epi8(lo)), hi - lo);
+}
+
+__attribute__((target("sse2"))) static inline __m128i EqualSse2(__m128i x, char c) {
+    return _mm_cmpeq_epi8(x, _mm_set1_epi8(c));
+}
+
+template <int kClass>
+__attribute__((target("sse2"))) static inline __m128i ClassMaskSse2(__m128i x) {
+    if constexpr (kClass == kSpace) {
+        return _mm_or_si128(EqualSse2(x, ' '), InRangeSse2(x, '\t', '\r'));
+    } else if constexpr (kClass == kDigit) {
+        return InRangeSse2(x, '0', '9');
+    } else {
+        auto letters = InRangeSse2(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+        auto digits = InRangeSse2(x, '0', '9');
+        auto compare = InRangeSse2(x, '<', '?');
+        auto mask = _mm_or_si128(_mm_or_si128(letters, digits), compare);
+        auto rest = _mm_or_si128(_mm_or_si128(EqualSse2(x, '*'), EqualSse2(x, '/')),
+                                 _mm_or_si128(EqualSse2(x, '#'), EqualSse2(x, '!')));
+        rest = _mm_or_si128(rest, _mm_or_si128(EqualSse2(x, '-'), EqualSse2(x, '[')));
+        rest = _mm_or_si128(rest, EqualSse2(x, ']'));
+        return _mm_or_si128(mask, rest);
+    }
+}
+
+template <int kClass>
+__attribute__((target("sse2"))) static const char* SkipSse2(const char* begin, const char* end) {
+    while (end - begin >= 16) {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        uint32_t outside = ~_mm_movemask_epi8(ClassMaskSse2<kClass>(x)) & 0xFFFF;
+        if (outside != 0) {
+            return begin + __builtin_ctz(outside);
+        }
+        begin += 16;
+    }
+    return SkipScalar<kClass>(begin, end);
+}
+
+__attribute__((target("avx2"))) static inline __m256i LessEqualAvx2(__m256i x, char bound) {
+    return _mm256_cmpeq_epi8(_mm256_subs_epu8(x, _mm256_set1_epi8(bound)),
+                             _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) static inline __m256i InRangeAvx2(__m256i x, char lo, char hi) {
+    return LessEqualAvx2(_mm256_sub_epi8(x, _mm256_set1_epi8(lo)), hi - lo);
+}
+
+__attribute__((target("avx2"))) static inline __m256i EqualAvx2(__m256i x, char c) {
+    return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c));
+}
+
+template <int kClass>
+__attribute__((target("avx2"))) static inline __m256i ClassMaskAvx2(__m256i x) {
+    if constexpr (kClass == kSpace) {
+        return _mm256_or_si256(EqualAvx2(x, ' '), InRangeAvx2(x, '\t', '\r'));
+    } else if constexpr (kClass == kDigit) {
+        return InRangeAvx2(x, '0', '9');
+    } else {
+        auto letters = InRangeAvx2(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+        auto digits = InRangeAvx2(x, '0', '9');
+        auto compare = InRangeAvx2(x, '<', '?');
+        auto mask = _mm256_or_si256(_mm256_or_si256(letters, digits), compare);
+        auto rest = _mm256_or_si256(_mm256_or_si256(EqualAvx2(x, '*'), EqualAvx2(x, '/')),
+                                    _mm256_or_si256(EqualAvx2(x, '#'), EqualAvx2(x, '!')));
+        rest = _mm256_or_si256(rest, _mm256_or_si256(EqualAvx2(x, '-'), EqualAvx2(x, '[')));
+        rest = _mm256_or_si256(rest, EqualAvx2(x, ']'));
+        return _mm256_or_si256(mask, rest);
+    }
+}
+
+template <int kClass>
+__attribute__((target("avx2"))) static const char* SkipAvx2(const char* begin, const char* end) {
+    while (end - begin >= 32) {
+        auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        uint32_t outside = ~static_cast<uint32_t>(_mm256_movemask_epi8(ClassMaskAvx2<kClass>(x)));
+        if (outside != 0) {
+            return begin + __builtin_ctz(outside);
+        }
+        begin += 32;
+    }
+    return SkipSse2<kClass>(begin, end);
+}
+
+#endif
+
+struct Scanners {
+    ScanLevel level;
+    const char* (*spaces)(const char*, const char*);
+    const char* (*digits)(const char*, const char*);
+    const char* (*symbol)(const char*, const char*);
+};
+
+static Scanners MakeScanners(ScanLevel level) {
+#ifdef SCHEME_SCAN_X86
+    __builtin_cpu_init();
+    if (level == ScanLevel::AVX2 && __builtin_cpu_supports("avx2")) {
+        return {ScanLevel::AVX2, SkipAvx2<kSpace>, SkipAvx2<kDigit>, SkipAvx2<kSymbol>};
+    }
+    if (level != ScanLevel::SCALAR && __builtin_cpu_supports("sse2")) {
+        return {ScanLevel::SSE2, SkipSse2<kSpace>, SkipSse2<kDigit>, SkipSse2<kSymbol>};
+    }
+#endif
+    return {ScanLevel::SCALAR, SkipScalar<kSpace>, SkipScalar<kDigit>, SkipScalar<kSymbol>};
+}
+
+// Picked on first use rather than by a dynamic initializer, so that tokenizers used while other
+// translation units are initialized find it ready.
+static Scanners& GetScanners() {
+    static Scanners scanners = MakeScanners(ScanLevel::AVX2);
+    return scanners;
+}
+
+// Close to the end of the buffer there is no full vector to load anyway.
+static constexpr ptrdiff_t kShortRun = 16;
+
+const char* SkipSpaces(const char* begin, const char* end) {
+    if (end - begin < kShortRun) {
+        return SkipScalar<kSpace>(begin, end);
+    }
+    return GetScanners().spaces(begin, end);
+}
+
+const char* SkipDigits(const char* begin, const char* end) {
+    if (end - begin < kShortRun) {
+        return SkipScalar<kDigit>(begin, end);
+    }
+    return GetScanners().digits(begin, end);
+}
+
+const char* SkipSymbol(const char* begin, const char* end) {
+    if (end - begin < kShortRun) {
+        return SkipScalar<kSymbol>(begin, end);
+    }
+    return GetScanners().symbol(begin, end);
+}
+
+ScanLevel GetScanLevel() {
+    return GetScanners().level;
+}
+
+void SetScanLevel(ScanLevel level) {
+    GetScanners() = MakeScanners(level);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// Character classes shared by every tokenizer, so classifying a char is a single table load.
+enum CharClass : uint8_t {
+    kSpace = 1 << 0,
+    kDigit = 1 << 1,
+    kSymbolBegin = 1 << 2,
+    kSymbol = 1 << 3,
+};
+
+constexpr std::array<uint8_t, 256> MakeCharClasses() {
+    std::array<uint8_t, 256> classes{};
+    for (unsigned char x : std::string_view(" \t\n\v\f\r")) {
+        classes[x] |= kSpace;
+    }
+    for (int x = 'a'; x <= 'z'; ++x) {
+        classes[x] |= kSymbolBegin | kSymbol;
+        classes[x - 'a' + 'A'] |= kSymbolBegin | kSymbol;
+    }
+    for (int x = '0'; x <= '9'; ++x) {
+        classes[x] |= kDigit | kSymbol;
+    }
+    for (unsigned char x : std::string_view("<=>*/#[]")) {
+        classes[x] |= kSymbolBegin | kSymbol;
+    }
+    for (unsigned char x : std::string_view("?!-")) {
+        classes[x] |= kSymbol;
+    }
+    return classes;
+}
+
+inline constexpr std::array<uint8_t, 256> kCharClasses = MakeCharClasses();
+
+// EOF comes as -1, which never belongs to any class.
+inline bool HasClass(int x, uint8_t char_class) {
+    return x >= 0 && (kCharClasses[x] & char_class);
+}
+
+// Each Skip* returns the first position in [begin, end) whose char is outside the class.
+// Long runs are scanned 16 or 32 bytes at a time, the implementation is picked at runtime.
+const char* SkipSpaces(const char* begin, const char* end);
+
+const char* SkipDigits(const char* begin, const char* end);
+
+const char* SkipSymbol(const char* begin, const char* end);
+
+enum class ScanLevel { SCALAR, SSE2, AVX2 };
+
+ScanLevel GetScanLevel();
+
+// Levels the cpu can't run are clamped to the best supported one. Meant for benchmarks and tests.
+void SetScanLevel(ScanLevel level);
@@ -0,0 +1,404 @@
+#include <collector.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+static thread_local Collector* current_collector = nullptr;
+
+// What is left of a promoted young object.
+struct Forwarded : Object {
+    using Object::Object;
+
+    Object* to;
+};
+
+// References from young garbage to a promoted object are still released when it is broken up,
+// they must not bring the count of what is left to zero.
+static constexpr uint32_t kStaleReferences = 1u << 31;
+
+// Looking at the clock costs more than marking an object, so it is done once per batch.
+static constexpr size_t kCheckEvery = 256;
+
+static size_t SizeOf(ObjectType type) {
+    switch (type) {
+        case ObjectType::NUMBER:
+            return sizeof(Number);
+        case ObjectType::BIGNUMBER:
+            return sizeof(BigNumber);
+        case ObjectType::SYMBOL:
+            return sizeof(Symbol);
+        case ObjectType::CELL:
+            return sizeof(Cell);
+        case ObjectType::CLOSURE:
+            return sizeof(Closure);
+    }
+    return 0;
+}
+
+template <class T, class... Args>
+static T* NewOld(Args&&... args) {
+    return new (SlabAllocate(sizeof(T))) T(std::forward<Args>(args)...);
+}
+
+Collector* GetCurrentCollector() {
+    return current_collector;
+}
+
+void* AllocateYoung(Collector* collector, size_t size, size_t align) {
+    return collector->nursery_.Allocate(size, align);
+}
+
+void OnWrite(Object* parent, const Value& child) {
+    auto collector = current_collector;
+    if (!collector) {
+        return;
+    }
+    if ((parent->flags_ & Object::kMarked) && collector->IsMarking()) {
+        collector->Shade(child);
+    }
+    if (parent->flags_ & Object::kRemembered) {
+        return;
+    }
+    if (parent->flags_ & Object::kYoung) {
+        parent->flags_ |= Object::kRemembered;
+        collector->changed_young_.push_back(parent);
+    } else if (child.IsObject() && (child.GetObject()->flags_ & Object::kYoung)) {
+        parent->flags_ |= Object::kRemembered;
+        collector->remembered_.push_back(parent);
+    }
+}
+
+Collector::Collector(std::chrono::nanoseconds step_budget, size_t step_work,
+                     size_t nursery_size)
+    : step_budget_(step_budget), step_work_(step_work), nursery_size_(nursery_size) {
+}
+
+Collector::~Collector() {
+    for (const auto& value : touched_) {
+        value.GetObject()->flags_ &= ~Object::kMarked;
+    }
+    if (phase_ == Phase::SWEEPING) {
+        heap_.erase(heap_.begin() + kept_, heap_.begin() + next_);
+    }
+    for (auto object : heap_) {
+        if (object->flags_ & Object::kDead) {
+            Free(object);
+        } else {
+            object->flags_ &= ~(Object::kTracked | Object::kMarked);
+        }
+    }
+}
+
+void Collector::AddRoot(Value* root) {
+    roots_.push_back(root);
+}
+
+void Collector::RemoveRoot(Value* root) {
+    auto it = std::find(roots_.begin(), roots_.end(), root);
+    if (it != roots_.end()) {
+        *it = roots_.back();
+        roots_.pop_back();
+    }
+}
+
+void Collector::Minor(std::span<Value* const> roots) {
+    auto start = Clock::now();
+    CollectYoung(roots);
+    CountPause(start);
+}
+
+bool Collector::IsNurseryFull() const {
+    return nursery_.GetUsed() >= nursery_size_;
+}
+
+bool Collector::Step() {
+    auto start = Clock::now();
+    CollectYoung({});
+    work_left_ = step_work_;
+    work_done_ = 0;
+    bool due = promoted_since_cycle_ >= std::max(kCycleThreshold, stats_.live_objects);
+    bool done = (phase_ != Phase::IDLE || due) && Work(start + step_budget_);
+    stats_.last_step_work = work_done_;
+    stats_.max_step_work = std::max(stats_.max_step_work, work_done_);
+    CountPause(start);
+    return done;
+}
+
+void Collector::Collect() {
+    auto start = Clock::now();
+    CollectYoung({});
+    work_left_ = SIZE_MAX;
+    work_done_ = 0;
+    if (phase_ != Phase::IDLE) {
+        Work(Clock::time_point::max());
+    }
+    Work(Clock::time_point::max());
+    CountPause(start);
+}
+
+bool Collector::IsMarking() const {
+    return phase_ == Phase::MARKING;
+}
+
+size_t Collector::GetYoungBytes() const {
+    return nursery_.GetUsed();
+}
+
+const CollectorStats& Collector::GetStats() const {
+    return stats_;
+}
+
+// Cells and closures are the only objects with references in them.
+template <class Visit>
+void Collector::ForEachChild(Object* object, Visit visit) {
+    if (object->flags_ & Object::kDead) {
+        return;
+    }
+    if (object->type_ == ObjectType::CELL) {
+        auto cell = static_cast<Cell*>(object);
+        visit(cell->left_son_);
+        visit(cell->right_son_);
+    } else if (object->type_ == ObjectType::CLOSURE) {
+        for (auto& value : static_cast<Closure*>(object)->captured_) {
+            visit(value);
+        }
+    }
+}
+
+void Collector::CollectYoung(std::span<Value* const> roots) {
+    stats_.max_young_bytes = std::max(stats_.max_young_bytes, nursery_.GetUsed());
+    auto forward = [this](Value& child) { Forward(&child); };
+    for (auto root : roots_) {
+        Forward(root);
+    }
+    for (auto root : roots) {
+        Forward(root);
+    }
+    for (auto object : remembered_) {
+        object->flags_ &= ~Object::kRemembered;
+        ForEachChild(object, forward);
+    }
+    remembered_.clear();
+    while (!promoted_.empty()) {
+        auto object = promoted_.back();
+        promoted_.pop_back();
+        ForEachChild(object, forward);
+    }
+    // Nothing reached them, so whatever still holds on to them is a cycle.
+    for (auto object : changed_young_) {
+        if (!(object->flags_ & (Object::kDead | Object::kForwarded))) {
+            Break(object);
+        }
+    }
+    changed_young_.clear();
+    nursery_.Reset();
+    ++stats_.minor_collections;
+}
+
+void Collector::Forward(Value* slot) {
+    if (!slot->IsObject() || !(slot->GetObject()->flags_ & Object::kYoung)) {
+        return;
+    }
+    auto object = slot->GetObject();
+    if (!(object->flags_ & Object::kForwarded)) {
+        Promote(object);
+    }
+    auto to = static_cast<Forwarded*>(object)->to;
+    slot->bits_ = reinterpret_cast<uintptr_t>(to);
+    ++to->references_;
+}
+
+// Moves the contents to the old heap without touching any count, the new object is counted
+// as the references to it are forwarded.
+void Collector::Promote(Object* object) {
+    auto type = object->type_;
+    Object* to = nullptr;
+    switch (type) {
+        case ObjectType::NUMBER: {
+            auto number = static_cast<Number*>(object);
+            to = NewOld<Number>(number->GetValue());
+            number->~Number();
+            break;
+        }
+        case ObjectType::BIGNUMBER: {
+            auto number = static_cast<BigNumber*>(object);
+            to = NewOld<BigNumber>(std::move(number->number_));
+            number->~BigNumber();
+            break;
+        }
+        case ObjectType::SYMBOL: {
+            auto symbol = static_cast<Symbol*>(object);
+            auto moved = NewOld<Symbol>(symbol->GetInterned());
+            moved->SetBuiltin(symbol->GetBuiltin());
+            to = moved;
+            symbol->~Symbol();
+            break;
+        }
+        case ObjectType::CELL: {
+            auto cell = static_cast<Cell*>(object);
+            auto moved = NewOld<Cell>(std::move(cell->left_son_), std::move(cell->right_son_));
+            cell->~Cell();
+            promoted_.push_back(moved);
+            to = moved;
+            break;
+        }
+        case ObjectType::CLOSURE: {
+            auto closure = static_cast<Closure*>(object);
+            auto moved =
+                NewOld<Closure>(std::move(closure->lambda_), std::move(closure->captured_));
+            closure->~Closure();
+            promoted_.push_back(moved);
+            to = moved;
+            break;
+        }
+    }
+    Register(to);
+    auto forwarded = new (static_cast<void*>(object)) Forwarded(type);
+    forwarded->flags_ = Object::kInArena | Object::kYoung | Object::kForwarded;
+    forwarded->references_ = kStaleReferences;
+    forwarded->to = to;
+    ++stats_.promoted_objects;
+    ++promoted_since_cycle_;
+}
+
+void Collector::Register(Object* object) {
+    object->flags_ |= Object::kTracked;
+    heap_.push_back(object);
+    ++stats_.objects;
+    stats_.bytes += SizeOf(object->type_);
+    if (phase_ == Phase::MARKING) {
+        object->flags_ |= Object::kMarked;
+        ++marked_;
+        grey_.push_back(object);
+    }
+}
+
+// Arena objects are not traced: they are gone after the run that made them anyway.
+void Collector::Shade(const Value& value) {
+    if (!value.IsObject()) {
+        return;
+    }
+    auto object = value.GetObject();
+    if (object->flags_ & (Object::kMarked | Object::kInArena)) {
+        return;
+    }
+    object->flags_ |= Object::kMarked;
+    if (object->flags_ & Object::kTracked) {
+        ++marked_;
+    } else {
+        // Keeps it alive while it is on the grey list.
+        touched_.push_back(value);
+    }
+    grey_.push_back(object);
+}
+
+// Takes one object out of the budget of the step, false when it is spent.
+bool Collector::Spend(Clock::time_point deadline) {
+    if (work_left_ == 0 || (work_done_ % kCheckEvery == kCheckEvery - 1 &&
+                            Clock::now() >= deadline)) {
+        return false;
+    }
+    --work_left_;
+    ++work_done_;
+    return true;
+}
+
+bool Collector::Mark(Clock::time_point deadline) {
+    while (true) {
+        while (!grey_.empty()) {
+            if (!Spend(deadline)) {
+                return false;
+            }
+            auto object = grey_.back();
+            grey_.pop_back();
+            ForEachChild(object, [this](const Value& child) { Shade(child); });
+        }
+        // Roots may have changed since the cycle started. Nothing new here means marking is done.
+        for (auto root : roots_) {
+            Shade(*root);
+        }
+        if (grey_.empty()) {
+            break;
+        }
+    }
+    for (const auto& value : touched_) {
+        value.GetObject()->flags_ &= ~Object::kMarked;
+    }
+    touched_.clear();
+    stats_.live_objects = marked_;
+    phase_ = Phase::SWEEPING;
+    kept_ = next_ = 0;
+    end_ = heap_.size();
+    return true;
+}
+
+bool Collector::Sweep(Clock::time_point deadline) {
+    while (next_ < end_) {
+        if (!Spend(deadline)) {
+            return false;
+        }
+        auto object = heap_[next_++];
+        if (!(object->flags_ & (Object::kMarked | Object::kDead))) {
+            Break(object);
+        }
+        if (object->flags_ & Object::kDead) {
+            Free(object);
+            continue;
+        }
+        object->flags_ &= ~Object::kMarked;
+        heap_[kept_++] = object;
+    }
+    heap_.erase(heap_.begin() + kept_, heap_.begin() + end_);
+    kept_ = next_ = end_ = 0;
+    phase_ = Phase::IDLE;
+    ++stats_.cycles;
+    return true;
+}
+
+// Numbers and symbols can't be part of a cycle, they go away with whatever holds them.
+void Collector::Break(Object* object) {
+    if (object->type_ == ObjectType::CELL) {
+        auto cell = static_cast<Cell*>(object);
+        ++stats_.broken_objects;
+        auto first = std::move(cell->left_son_);
+        auto second = std::move(cell->right_son_);
+    } else if (object->type_ == ObjectType::CLOSURE) {
+        ++stats_.broken_objects;
+        auto captured = std::move(static_cast<Closure*>(object)->captured_);
+    }
+}
+
+void Collector::Free(Object* object) {
+    --stats_.objects;
+    stats_.bytes -= SizeOf(object->type_);
+    SlabFree(object, SizeOf(object->type_));
+}
+
+bool Collector::Work(Clock::time_point deadline) {
+    if (phase_ == Phase::IDLE) {
+        phase_ = Phase::MARKING;
+        marked_ = 0;
+        promoted_since_cycle_ = 0;
+        for (auto root : roots_) {
+            Shade(*root);
+        }
+    }
+    return (phase_ != Phase::MARKING || Mark(deadline)) && Sweep(deadline);
+}
+
+void Collector::CountPause(Clock::time_point start) {
+    std::chrono::nanoseconds pause = Clock::now() - start;
+    ++stats_.steps;
+    stats_.last_pause = pause;
+    stats_.max_pause = std::max(stats_.max_pause, pause);
+    stats_.total_pause += pause;
+}
+
+CollectorScope::CollectorScope(Collector* collector) : previous_(current_collector) {
+    current_collector = collector;
+}
+
+CollectorScope::~CollectorScope() {
+    current_collector = previous_;
+}
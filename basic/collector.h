@@ -0,0 +1,169 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "arena.h"
+#include "object.h"
+
+struct CollectorStats {
+    // Old objects and their bytes, including dead ones the sweep hasn't freed yet.
+    size_t objects = 0;
+    size_t bytes = 0;
+    // Old objects found reachable by the last finished cycle.
+    size_t live_objects = 0;
+    // Cells and closures in garbage cycles broken up so far, young and old.
+    size_t broken_objects = 0;
+    size_t cycles = 0;
+    size_t minor_collections = 0;
+    size_t promoted_objects = 0;
+    // The most the nursery held when it was emptied.
+    size_t max_young_bytes = 0;
+    size_t steps = 0;
+    // Objects marked or swept by the last step and by the biggest one.
+    size_t last_step_work = 0;
+    size_t max_step_work = 0;
+    std::chrono::nanoseconds last_pause{};
+    std::chrono::nanoseconds max_pause{};
+    std::chrono::nanoseconds total_pause{};
+};
+
+// Generational collector for the objects created while it is current. Reference counts still
+// free acyclic garbage right away, the collector finds what they can't: cycles.
+//
+// New objects are bump allocated in a nursery. A minor collection copies the young objects
+// reachable from the roots and from remembered old objects to the old heap, fixes the
+// references to them and resets the nursery, so it costs as much as the survivors do.
+// Young cells changed after they were built are the only ones that can be in a young cycle;
+// those not reached are broken up before the reset.
+//
+// The nursery has a size, but nothing is collected while an object is being made: once it is
+// full, the next safe point empties it. A program running under the collector has one at each
+// of its calls, with its own stack passed as extra roots, so a long run takes no more than the
+// nursery and what survives.
+//
+// The old heap is traced: marking starts from precise roots and runs in steps bounded by a time
+// budget and by a number of objects marked or swept, each step starting with a minor collection.
+// Steps may only run at safe points, where everything alive is reachable from the registered
+// roots. Between steps promoted objects are marked grey, stores into marked cells go through the
+// write barrier, and the roots are scanned again before marking is done.
+//
+// Sweeping is lazy too. An old object that reference counting has freed leaves a dead header
+// behind, and the sweep gives its memory back. An unmarked live object can only be part of
+// garbage kept alive by a cycle, so the sweep clears its children and reference counting does
+// the rest.
+//
+// Nothing outside the collector may point into the nursery, and young objects have to be gone
+// or promoted by the time the collector is destroyed.
+class Collector {
+public:
+    static constexpr std::chrono::microseconds kDefaultBudget{500};
+    static constexpr size_t kDefaultStepWork = 100000;
+    static constexpr size_t kDefaultNurserySize = 1 << 20;
+    // Steps start a new cycle once this many objects were promoted since the last one started,
+    // or as many as the last one found alive if that is more.
+    static constexpr size_t kCycleThreshold = 10000;
+
+    explicit Collector(std::chrono::nanoseconds step_budget = kDefaultBudget,
+                       size_t step_work = kDefaultStepWork,
+                       size_t nursery_size = kDefaultNurserySize);
+
+    Collector(const Collector&) = delete;
+    Collector& operator=(const Collector&) = delete;
+
+    // Objects still alive stay on the heap as plain reference counted ones.
+    ~Collector();
+
+    // The root has to stay at the same address until it is removed. A minor collection
+    // rewrites it when the object it holds is promoted.
+    void AddRoot(Value* root);
+
+    void RemoveRoot(Value* root);
+
+    // Empties the nursery. The extra roots count for this collection only, they may be anywhere
+    // the collector can't know of, like the stack of a running program.
+    void Minor(std::span<Value* const> roots = {});
+
+    // Whether the nursery holds its size or more, and the next safe point should empty it.
+    bool IsNurseryFull() const;
+
+    // Does a minor collection and then work for about one budget of time, and at most step_work
+    // objects, starting a new cycle if none is running and enough was promoted since the last
+    // one. Returns true when a cycle was completed.
+    bool Step();
+
+    // Completes the running cycle if any, then does a whole new one.
+    void Collect();
+
+    bool IsMarking() const;
+
+    size_t GetYoungBytes() const;
+
+    const CollectorStats& GetStats() const;
+
+private:
+    friend void* AllocateYoung(Collector* collector, size_t size, size_t align);
+    friend void OnWrite(Object* parent, const Value& child);
+
+    enum class Phase { IDLE, MARKING, SWEEPING };
+
+    using Clock = std::chrono::steady_clock;
+
+    void CollectYoung(std::span<Value* const> roots);
+    template <class Visit>
+    static void ForEachChild(Object* object, Visit visit);
+    void Register(Object* object);
+    void Forward(Value* slot);
+    void Promote(Object* object);
+    void Shade(const Value& value);
+    bool Spend(Clock::time_point deadline);
+    bool Mark(Clock::time_point deadline);
+    bool Sweep(Clock::time_point deadline);
+    void Break(Object* object);
+    void Free(Object* object);
+    bool Work(Clock::time_point deadline);
+    void CountPause(Clock::time_point start);
+
+    std::chrono::nanoseconds step_budget_;
+    size_t step_work_;
+    size_t nursery_size_;
+    Arena nursery_;
+    // Old objects with young children, and young cells that were changed.
+    std::vector<Object*> remembered_;
+    std::vector<Object*> changed_young_;
+    std::vector<Object*> promoted_;
+    Phase phase_ = Phase::IDLE;
+    std::vector<Object*> heap_;
+    std::vector<Value*> roots_;
+    std::vector<Object*> grey_;
+    // Untracked objects marked on the way, held until marking is done and their marks cleared.
+    std::vector<Value> touched_;
+    size_t marked_ = 0;
+    size_t promoted_since_cycle_ = 0;
+    // Objects the running step may still mark or sweep, and those it did.
+    size_t work_left_ = 0;
+    size_t work_done_ = 0;
+    // Sweep state: heap_[0, kept_) is swept, heap_[next_, end_) is not. Objects promoted
+    // during the sweep are appended after end_ and are left alone.
+    size_t kept_ = 0;
+    size_t next_ = 0;
+    size_t end_ = 0;
+    CollectorStats stats_;
+};
+
+// Makes a collector current until the end of the scope, objects created meanwhile start in
+// its nursery. An arena scope takes precedence.
+class CollectorScope {
+public:
+    explicit CollectorScope(Collector* collector);
+
+    CollectorScope(const CollectorScope&) = delete;
+    CollectorScope& operator=(const CollectorScope&) = delete;
+
+    ~CollectorScope();
+
+private:
+    Collector* previous_;
+};
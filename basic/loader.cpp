@@ -0,0 +1,191 @@
+#include <loader.h>
+#include <parser.h>
+#include <char_scan.h>
+#include <arena.h>
+#include <collector.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+    size_ = info.st_size;
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+        data_ = static_cast<char*>(data);
+        madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+    }
+}
+
+std::string_view MappedFile::GetContents() const {
+    return {data_, size_};
+}
+
+double LoadStats::BytesPerSecond() const {
+    return seconds > 0 ? bytes / seconds : 0;
+}
+
+// Pool threads have no arena or collector of their own and the caller's ones can't be shared
+// between threads, so every piece is built on the heap, wherever it is parsed.
+static void ReadData(std::string_view text, std::vector<Value>* data) {
+    ArenaScope heap{nullptr};
+    CollectorScope untracked{nullptr};
+    Tokenizer tokenizer{text};
+    while (!tokenizer.IsEnd()) {
+        data->push_back(Read(&tokenizer));
+    }
+}
+
+// Calls func(0), ..., func(count - 1) on the given number of threads.
+// The first exception in index order is rethrown once all threads are done.
+template <class Func>
+static void ParallelFor(size_t count, size_t threads, Func func) {
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> next = 0;
+    auto worker = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                func(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < std::min(threads, count); ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+static bool IsSpace(char x) {
+    return HasClass(static_cast<unsigned char>(x), kSpace);
+}
+
+// Cuts the text into pieces holding only whole top-level data. The text is split into equal
+// segments, paren balance of each one is counted in parallel, and prefix sums of those give
+// the depth at every segment start. Then each segment looks for its first whitespace at depth 0
+// that doesn't separate a quote from its datum, a segment lying wholly inside one datum has none
+// and just leaves its part to the piece before it.
+static std::vector<std::string_view> SplitTopLevel(std::string_view text, size_t segments,
+                                                   size_t threads) {
+    size_t segment_size = text.size() / segments + 1;
+    std::vector<int64_t> depth(segments + 1);
+    ParallelFor(segments, threads, [&](size_t i) {
+        auto segment = text.substr(std::min(i * segment_size, text.size()), segment_size);
+        int64_t balance = 0;
+        for (char x : segment) {
+            balance += (x == '(') - (x == ')');
+        }
+        depth[i + 1] = balance;
+    });
+    for (size_t i = 1; i <= segments; ++i) {
+        depth[i] += depth[i - 1];
+    }
+
+    std::vector<size_t> cuts(segments, std::string_view::npos);
+    ParallelFor(segments, threads, [&](size_t i) {
+        size_t begin = std::min(i * segment_size, text.size());
+        size_t end = std::min(begin + segment_size, text.size());
+        size_t last = begin;
+        while (last > 0 && IsSpace(text[last - 1])) {
+            --last;
+        }
+        bool after_quote = last > 0 && text[last - 1] == '\'';
+        int64_t current = depth[i];
+        for (size_t pos = begin; pos < end; ++pos) {
+            char x = text[pos];
+            if (IsSpace(x)) {
+                if (current == 0 && !after_quote) {
+                    cuts[i] = pos;
+                    return;
+                }
+                continue;
+            }
+            current += (x == '(') - (x == ')');
+            after_quote = x == '\'';
+        }
+    });
+
+    std::vector<std::string_view> pieces;
+    size_t begin = 0;
+    for (size_t cut : cuts) {
+        if (cut != std::string_view::npos && cut > begin) {
+            pieces.push_back(text.substr(begin, cut - begin));
+            begin = cut;
+        }
+    }
+    pieces.push_back(text.substr(begin));
+    return pieces;
+}
+
+LoadResult LoadFile(const std::string& path, size_t threads) {
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file{path};
+    auto contents = file.GetContents();
+
+    LoadResult result;
+    if (threads <= 1 || contents.size() < kMinParallelLoad) {
+        ReadData(contents, &result.data);
+        threads = 1;
+    } else {
+        auto pieces = SplitTopLevel(contents, threads * 4, threads);
+        std::vector<std::vector<Value>> data(pieces.size());
+        ParallelFor(pieces.size(), threads, [&](size_t i) { ReadData(pieces[i], &data[i]); });
+        result.stats.pieces = pieces.size();
+        size_t total = 0;
+        for (const auto& piece : data) {
+            total += piece.size();
+        }
+        result.data.reserve(total);
+        for (auto& piece : data) {
+            std::move(piece.begin(), piece.end(), std::back_inserter(result.data));
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.stats.bytes = contents.size();
+    result.stats.data = result.data.size();
+    result.stats.threads = threads;
+    result.stats.seconds = elapsed.count();
+    return result;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "object.h"
+
+// Read-only mapping of a whole file, pages are brought in by the kernel as the tokenizer walks
+// over them, so even huge files are never copied to the heap.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    std::string_view GetContents() const;
+
+private:
+    char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+struct LoadStats {
+    size_t bytes = 0;
+    size_t data = 0;
+    size_t threads = 1;
+    size_t pieces = 1;
+    double seconds = 0;
+
+    double BytesPerSecond() const;
+};
+
+struct LoadResult {
+    std::vector<Value> data;
+    LoadStats stats;
+};
+
+// Smaller files are read on the calling thread, splitting them isn't worth starting threads.
+inline constexpr size_t kMinParallelLoad = 1 << 20;
+
+// Reads every top-level datum of a file. Large files are cut at top-level boundaries and the
+// pieces are parsed on the given number of threads, the data keep their order in the file.
+// The data are always built on the heap, whatever arena or collector is current.
+// Throws std::system_error if the file can't be mapped.
+LoadResult LoadFile(const std::string& path,
+                    size_t threads = std::thread::hardware_concurrency());
@@ -0,0 +1,126 @@
+#include <numeric.h>
+
+#include <error.h>
+
+bool IsInteger(const Value& value) {
+    return Is<Number>(value) || Is<BigNumber>(value);
+}
+
+Value AddSlow(const Value& a, const Value& b) {
+    int64_t result;
+    if (Is<Number>(a) && Is<Number>(b) &&
+        !__builtin_add_overflow(As<Number>(a)->GetValue(), As<Number>(b)->GetValue(), &result)) {
+        return Value::Integer(result);
+    }
+    return FromBigInt(ToBigInt(a) + ToBigInt(b));
+}
+
+Value SubtractSlow(const Value& a, const Value& b) {
+    int64_t result;
+    if (Is<Number>(a) && Is<Number>(b) &&
+        !__builtin_sub_overflow(As<Number>(a)->GetValue(), As<Number>(b)->GetValue(), &result)) {
+        return Value::Integer(result);
+    }
+    return FromBigInt(ToBigInt(a) - ToBigInt(b));
+}
+
+Value MultiplySlow(const Value& a, const Value& b) {
+    int64_t result;
+    if (Is<Number>(a) && Is<Number>(b) &&
+        !__builtin_mul_overflow(As<Number>(a)->GetValue(), As<Number>(b)->GetValue(), &result)) {
+        return Value::Integer(result);
+    }
+    return FromBigInt(ToBigInt(a) * ToBigInt(b));
+}
+
+Value Quotient(const Value& a, const Value& b) {
+    if (Is<Number>(b) && As<Number>(b)->GetValue() == 0) {
+        throw RuntimeError("Divididng by zero");
+    }
+    if (Is<Number>(a) && Is<Number>(b)) {
+        auto dividend = As<Number>(a)->GetValue();
+        auto divisor = As<Number>(b)->GetValue();
+        // The one quotient of two int64 values that doesn't fit.
+        if (dividend != INT64_MIN || divisor != -1) {
+            return Value::Integer(dividend / divisor);
+        }
+    }
+    BigInt quotient;
+    BigInt::DivMod(ToBigInt(a), ToBigInt(b), &quotient, nullptr);
+    return FromBigInt(std::move(quotient));
+}
+
+Value Negate(const Value& value) {
+    return Subtract(Value::Integer(0), value);
+}
+
+Value Abs(const Value& value) {
+    return Compare(value, Value::Integer(0)) < 0 ? Negate(value) : value;
+}
+
+int Compare(const Value& a, const Value& b) {
+    if (Is<Number>(a) && Is<Number>(b)) {
+        auto first = As<Number>(a)->GetValue();
+        auto second = As<Number>(b)->GetValue();
+        return (first > second) - (first < second);
+    }
+    return Compare(ToBigInt(a), ToBigInt(b));
+}
+
+Value Expt(const Value& base, const Value& exponent) {
+    if (!Is<Number>(exponent) || As<Number>(exponent)->GetValue() < 0) {
+        throw RuntimeError("Invalid argument to expt func");
+    }
+    auto power = static_cast<uint64_t>(As<Number>(exponent)->GetValue());
+    if (Is<Number>(base)) {
+        // Square and multiply in machine words until something overflows.
+        int64_t result = 1;
+        int64_t square = As<Number>(base)->GetValue();
+        auto rest = power;
+        bool overflow = false;
+        while (rest && !overflow) {
+            if (rest & 1) {
+                overflow = __builtin_mul_overflow(result, square, &result);
+            }
+            rest >>= 1;
+            if (rest && !overflow) {
+                overflow = __builtin_mul_overflow(square, square, &square);
+            }
+        }
+        if (!overflow) {
+            return Value::Integer(result);
+        }
+    }
+    return FromBigInt(BigInt::Pow(ToBigInt(base), power));
+}
+
+Value ModularExpt(const Value& base, const Value& exponent, const Value& modulus) {
+    if (Compare(exponent, Value::Integer(0)) < 0) {
+        throw RuntimeError("Invalid argument to modular-expt func");
+    }
+    if (Is<Number>(modulus) && As<Number>(modulus)->GetValue() == 0) {
+        throw RuntimeError("Divididng by zero");
+    }
+    return FromBigInt(BigInt::ModPow(ToBigInt(base), ToBigInt(exponent), ToBigInt(modulus)));
+}
+
+BigInt ToBigInt(const Value& value) {
+    if (Is<Number>(value)) {
+        return BigInt(As<Number>(value)->GetValue());
+    }
+    return As<BigNumber>(value)->GetValue();
+}
+
+Value FromBigInt(BigInt value) {
+    if (value.FitsInt64()) {
+        return Value::Integer(value.ToInt64());
+    }
+    return New<BigNumber>(std::move(value));
+}
+
+std::string IntegerToString(const Value& value) {
+    if (Is<Number>(value)) {
+        return std::to_string(As<Number>(value)->GetValue());
+    }
+    return As<BigNumber>(value)->GetValue().ToString();
+}
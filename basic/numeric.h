@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+#include <object.h>
+
+// Exact integer arithmetic over the whole tower: fixnums, boxed 64-bit Numbers and BigNumbers.
+// Results always come back in the smallest representation that holds them, so equal integers
+// look the same. Two fixnums take an inline path, 64-bit values an overflow checked one, and
+// only what overflows goes through BigInt.
+
+bool IsInteger(const Value& value);
+
+Value AddSlow(const Value& a, const Value& b);
+Value SubtractSlow(const Value& a, const Value& b);
+Value MultiplySlow(const Value& a, const Value& b);
+
+inline Value Add(const Value& a, const Value& b) {
+    if (a.IsFixnum() && b.IsFixnum()) {
+        // Two 63-bit values can't overflow 64 bits.
+        return Value::Integer(a.GetFixnum() + b.GetFixnum());
+    }
+    return AddSlow(a, b);
+}
+
+inline Value Subtract(const Value& a, const Value& b) {
+    if (a.IsFixnum() && b.IsFixnum()) {
+        return Value::Integer(a.GetFixnum() - b.GetFixnum());
+    }
+    return SubtractSlow(a, b);
+}
+
+inline Value Multiply(const Value& a, const Value& b) {
+    int64_t result;
+    if (a.IsFixnum() && b.IsFixnum() &&
+        !__builtin_mul_overflow(a.GetFixnum(), b.GetFixnum(), &result)) {
+        return Value::Integer(result);
+    }
+    return MultiplySlow(a, b);
+}
+
+// Truncates like C++. Throws RuntimeError when dividing by zero.
+Value Quotient(const Value& a, const Value& b);
+
+Value Negate(const Value& value);
+
+Value Abs(const Value& value);
+
+// -1, 0 or 1.
+int Compare(const Value& a, const Value& b);
+
+// The exponent has to be a non-negative 64-bit integer, otherwise throws RuntimeError.
+Value Expt(const Value& base, const Value& exponent);
+
+// base^exponent modulo |modulus|, in [0, |modulus|).
+Value ModularExpt(const Value& base, const Value& exponent, const Value& modulus);
+
+BigInt ToBigInt(const Value& value);
+
+// Back to a fixnum or a boxed Number whenever the value fits.
+Value FromBigInt(BigInt value);
+
+std::string IntegerToString(const Value& value);
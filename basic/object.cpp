@@ -0,0 +1,248 @@
+#include <object.h>
+
+#include <new>
+
+template <class T>
+void Object::Dispose() {
+    auto object = static_cast<T*>(this);
+    if (flags_ & kYoung) {
+        // A minor collection has to tell dead young cells from live ones.
+        object->~T();
+        auto header = new (static_cast<void*>(object)) Object(T::kType);
+        header->flags_ = kInArena | kYoung | kDead;
+    } else if (flags_ & kInArena) {
+        object->~T();
+    } else if (flags_ & kTracked) {
+        // Its collector may still hold the pointer, so only a dead header is left behind.
+        object->~T();
+        auto header = new (static_cast<void*>(object)) Object(T::kType);
+        header->flags_ = kTracked | kDead;
+    } else if (flags_ & kInHeapRun) {
+        object->~T();
+        SlabFreeInRun(object, sizeof(T));
+    } else {
+        object->~T();
+        SlabFree(object, sizeof(T));
+    }
+}
+
+// Out of line, so releasing a reference inlines to a decrement and a rarely taken call.
+void Object::Destroy() {
+    switch (type_) {
+        case ObjectType::NUMBER:
+            Dispose<Number>();
+            break;
+        case ObjectType::BIGNUMBER:
+            Dispose<BigNumber>();
+            break;
+        case ObjectType::SYMBOL:
+            Dispose<Symbol>();
+            break;
+        case ObjectType::CELL:
+            Dispose<Cell>();
+            break;
+        case ObjectType::CLOSURE:
+            Dispose<Closure>();
+            break;
+    }
+}
+
+// Whether freeing the value could go on to free more of the graph: it is the only reference
+// to a cell or a closure.
+bool Cell::IsDeep(const Value& value) {
+    return value.IsUnique() && (Is<Cell>(value) || Is<Closure>(value));
+}
+
+// Tears down what only this value holds without recursing, however deep the graph is. Cells on
+// the first side are rotated onto the second one, so the cells left to free form a chain that
+// is unlinked a cell at a time, the dying cells are the worklist. Closures have no slot to
+// rotate through, so they and what they hold alone wait on a stack instead. Every object is
+// freed once nothing deep is left in it, and its destructor goes no further.
+void Cell::Unlink(Value current) {
+    std::vector<Value> closures;
+    while (true) {
+        if (current.IsUnique() && Is<Cell>(current)) {
+            auto cell = As<Cell>(current);
+            if (cell->left_son_.IsUnique() && Is<Cell>(cell->left_son_)) {
+                auto left = std::move(cell->left_son_);
+                auto left_cell = As<Cell>(left);
+                cell->left_son_ = std::move(left_cell->right_son_);
+                left_cell->right_son_ = std::move(current);
+                current = std::move(left);
+                continue;
+            }
+            if (IsDeep(cell->left_son_)) {
+                closures.push_back(std::move(cell->left_son_));
+            }
+            auto next = std::move(cell->right_son_);
+            current = std::move(next);
+            continue;
+        }
+        if (current.IsUnique() && Is<Closure>(current)) {
+            for (auto& value : As<Closure>(current)->captured_) {
+                if (IsDeep(value)) {
+                    closures.push_back(std::move(value));
+                }
+            }
+        }
+        current = nullptr;
+        if (closures.empty()) {
+            return;
+        }
+        current = std::move(closures.back());
+        closures.pop_back();
+    }
+}
+
+Cell::~Cell() {
+    if (IsDeep(left_son_)) {
+        Unlink(std::move(left_son_));
+    }
+    if (IsDeep(right_son_)) {
+        Unlink(std::move(right_son_));
+    }
+}
+
+Closure::~Closure() {
+    for (auto& value : captured_) {
+        if (Cell::IsDeep(value)) {
+            Cell::Unlink(std::move(value));
+        }
+    }
+}
+
+// Cells earlier in the run may no longer jump past this one.
+void Cell::BreakRun() {
+    run_ = 0;
+    size_t distance = 0;
+    for (auto cell = this; cell->flags_ & kInRun;) {
+        --cell;
+        ++distance;
+        if (cell->run_ < distance) {
+            break;
+        }
+        cell->run_ = distance;
+    }
+}
+
+// Run lengths have to fit into the spare bytes of the header.
+static constexpr size_t kMaxRun = UINT16_MAX;
+
+Value NewList(std::span<Value> elements, Value tail) {
+    Arena* arena = GetCurrentArena();
+    Collector* collector = arena ? nullptr : GetCurrentCollector();
+    uint8_t flags = arena       ? Object::kInArena
+                    : collector ? Object::kInArena | Object::kYoung
+                                : Object::kInHeapRun;
+    for (size_t end = elements.size(); end > 0;) {
+        size_t count = std::min(end, kMaxRun + 1);
+        void* memory;
+        if (arena) {
+            memory = arena->Allocate(count * sizeof(Cell), alignof(Cell));
+        } else if (collector) {
+            memory = AllocateYoung(collector, count * sizeof(Cell), alignof(Cell));
+        } else {
+            // Only as many as the span has room for.
+            memory = SlabAllocateRun(sizeof(Cell), &count);
+        }
+        size_t begin = end - count;
+        auto cells = static_cast<Cell*>(memory);
+        for (size_t i = count; i-- > 0;) {
+            Value next = i + 1 < count ? Value(cells + i + 1) : std::move(tail);
+            auto cell = new (cells + i) Cell(std::move(elements[begin + i]), std::move(next));
+            cell->flags_ |= flags | (i > 0 ? Object::kInRun : 0);
+            cell->run_ = count - 1 - i;
+        }
+        tail = Value(cells);
+        end = begin;
+    }
+    return tail;
+}
+
+Value CopyToHeap(const Value& value) {
+    auto in_arena = [](const Value& value) {
+        return value.IsObject() && (value.GetObject()->flags_ & Object::kInArena);
+    };
+    if (!in_arena(value)) {
+        return value;
+    }
+    switch (value.GetObject()->GetType()) {
+        case ObjectType::NUMBER:
+            return New<Number>(As<Number>(value)->GetValue());
+        case ObjectType::BIGNUMBER:
+            return New<BigNumber>(As<BigNumber>(value)->GetValue());
+        case ObjectType::SYMBOL: {
+            auto symbol = As<Symbol>(value);
+            auto copy = New<Symbol>(symbol->GetInterned());
+            As<Symbol>(copy)->SetBuiltin(symbol->GetBuiltin());
+            return copy;
+        }
+        case ObjectType::CELL:
+        case ObjectType::CLOSURE:
+            break;
+    }
+    // Lists and closures may be nested deep, so the ones being copied are kept on a stack: the
+    // values copied so far, and the rest of the list after them or the closure whose captured
+    // values they are. A closure ending a list is copied on the stack as well, as its tail.
+    struct Copying {
+        const Value* rest;
+        const Closure* closure;
+        std::vector<Value> copied;
+        Value tail;
+        bool is_tail;
+    };
+    std::vector<Copying> stack;
+    auto push = [&stack](const Value& from, bool is_tail) {
+        if (Is<Closure>(from)) {
+            stack.push_back({nullptr, As<Closure>(from), {}, nullptr, is_tail});
+        } else {
+            stack.push_back({&from, nullptr, {}, nullptr, is_tail});
+        }
+    };
+    auto is_nested = [&in_arena](const Value& value) {
+        return in_arena(value) && (Is<Cell>(value) || Is<Closure>(value));
+    };
+    push(value, false);
+    while (true) {
+        auto& top = stack.back();
+        const Value* next = nullptr;
+        if (top.closure) {
+            const auto& captured = top.closure->GetCaptured();
+            if (top.copied.size() < captured.size()) {
+                next = &captured[top.copied.size()];
+            }
+        } else if (Is<Cell>(*top.rest) && in_arena(*top.rest)) {
+            auto cell = As<Cell>(*top.rest);
+            top.rest = &cell->GetSecond();
+            next = &cell->GetFirst();
+        } else if (top.tail == nullptr && is_nested(*top.rest)) {
+            push(*top.rest, true);
+            continue;
+        }
+        if (next) {
+            if (is_nested(*next)) {
+                push(*next, false);
+            } else {
+                top.copied.push_back(CopyToHeap(*next));
+            }
+            continue;
+        }
+        Value copy;
+        if (top.closure) {
+            copy = New<Closure>(top.closure->GetLambda(), std::move(top.copied));
+        } else {
+            auto tail = top.tail != nullptr ? std::move(top.tail) : CopyToHeap(*top.rest);
+            copy = NewList(top.copied, std::move(tail));
+        }
+        bool is_tail = top.is_tail;
+        stack.pop_back();
+        if (stack.empty()) {
+            return copy;
+        }
+        if (is_tail) {
+            stack.back().tail = std::move(copy);
+        } else {
+            stack.back().copied.push_back(std::move(copy));
+        }
+    }
+}
@@ -1,74 +1,414 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-class Object : public std::enable_shared_from_this<Object> {
+#include <arena.h>
+#include <bigint.h>
+#include <slab.h>
+#include <symbol_table.h>
+
+class Object;
+class Value;
+class Collector;
+class Lambda;
+
+// Every heap type has a tag of its own, so Is<T> is a single compare instead of RTTI.
+enum class ObjectType : uint8_t { NUMBER, BIGNUMBER, SYMBOL, CELL, CLOSURE };
+
+// See collector.h.
+Collector* GetCurrentCollector();
+void* AllocateYoung(Collector* collector, size_t size, size_t align);
+void OnWrite(Object* parent, const Value& child);
+
+// Common header of heap objects, 8 bytes with no vtable: the tag alone says how to destroy one.
+// Counts are not atomic, a graph of values belongs to one thread at a time.
+class Object {
 public:
-    virtual ~Object() = default;
+    explicit Object(ObjectType type) : type_(type){};
+
+    Object(const Object&) = delete;
+    Object& operator=(const Object&) = delete;
+
+    ObjectType GetType() const {
+        return type_;
+    };
+
+protected:
+    ~Object() = default;
+
+    // Must precede every store into an existing object, see Collector.
+    void WriteBarrier(const Value& child) {
+        if (flags_ & (kMarked | kTracked | kYoung)) {
+            OnWrite(this, child);
+        }
+    };
+
+private:
+    friend class Value;
+    friend class Collector;
+    friend class Reclaimer;
+    friend class Cell;
+    friend void OnWrite(Object* parent, const Value& child);
+
+    template <class T, class... Args>
+    friend Value New(Args&&... args);
+    friend Value NewList(std::span<Value> elements, Value tail);
+    friend Value CopyToHeap(const Value& value);
+
+    template <class T>
+    void Dispose();
+    void Destroy();
+
+    static constexpr uint8_t kInArena = 1 << 0;
+    // Registered with a collector, which frees the memory once the object is dead.
+    static constexpr uint8_t kTracked = 1 << 1;
+    static constexpr uint8_t kMarked = 1 << 2;
+    static constexpr uint8_t kDead = 1 << 3;
+    // In the nursery of a collector, always together with kInArena.
+    static constexpr uint8_t kYoung = 1 << 4;
+    static constexpr uint8_t kRemembered = 1 << 5;
+    static constexpr uint8_t kForwarded = 1 << 6;
+    // A cell of a run on the heap, see SlabAllocateRun. Shares the bit with kForwarded, which
+    // only young objects have.
+    static constexpr uint8_t kInHeapRun = 1 << 6;
+    // A cell that follows another one of its run, see Cell::GetRun.
+    static constexpr uint8_t kInRun = 1 << 7;
+
+    uint32_t references_ = 0;
+    ObjectType type_;
+    uint8_t flags_ = 0;
+};
+
+// A Scheme value in one machine word. Small integers, booleans and the empty list live in
+// the word itself and never allocate; anything else is a counted reference to an Object.
+//   ...000  Object*, zero is the empty list
+//   .....1  integer shifted left by one
+//   ...010  #f
+//   ...110  #t
+class Value {
+public:
+    Value() = default;
+    Value(std::nullptr_t){};
+    Value(Object* object) : bits_(reinterpret_cast<uintptr_t>(object)) {
+        Retain();
+    };
+    Value(const Value& other) : bits_(other.bits_) {
+        Retain();
+    };
+    Value(Value&& other) noexcept : bits_(std::exchange(other.bits_, 0)){};
+    Value& operator=(Value other) noexcept {
+        std::swap(bits_, other.bits_);
+        return *this;
+    };
+    ~Value() {
+        Release();
+    };
+
+    // Integers that don't fit into 63 bits are boxed into a Number.
+    static Value Integer(int64_t value);
+    static Value Boolean(bool value) {
+        Value result;
+        result.bits_ = value ? kTrue : kFalse;
+        return result;
+    };
+
+    bool IsFixnum() const {
+        return bits_ & 1;
+    };
+    bool IsBoolean() const {
+        return (bits_ & 3) == 2;
+    };
+    bool IsFalse() const {
+        return bits_ == kFalse;
+    };
+    bool IsObject() const {
+        return bits_ != 0 && (bits_ & 7) == 0;
+    };
+    // The only reference, so the object may be taken apart.
+    bool IsUnique() const {
+        return IsObject() && GetObject()->references_ == 1;
+    };
+
+    int64_t GetFixnum() const {
+        return static_cast<int64_t>(bits_) >> 1;
+    };
+    bool GetBoolean() const {
+        return bits_ == kTrue;
+    };
+    Object* GetObject() const {
+        return reinterpret_cast<Object*>(bits_);
+    };
+
+    explicit operator bool() const {
+        return bits_ != 0;
+    };
+    bool operator==(std::nullptr_t) const {
+        return bits_ == 0;
+    };
+    // Identity, like eq?.
+    bool operator==(const Value& other) const {
+        return bits_ == other.bits_;
+    };
+
+private:
+    friend class Collector;
+
+    static constexpr uintptr_t kFalse = 2;
+    static constexpr uintptr_t kTrue = 6;
+
+    void Retain() const {
+        if (IsObject()) {
+            ++GetObject()->references_;
+        }
+    };
+    void Release() {
+        if (IsObject() && --GetObject()->references_ == 0) {
+            GetObject()->Destroy();
+        }
+    };
+
+    uintptr_t bits_ = 0;
 };
 
 class Number : public Object {
 public:
-    Number(int n) : number_(n){};
-    int GetValue() const {
+    static constexpr ObjectType kType = ObjectType::NUMBER;
+
+    Number(int64_t n) : Object(kType), number_(n){};
+    int64_t GetValue() const {
         return number_;
     };
 
 private:
-    int number_{};
+    int64_t number_{};
 };
 
-class Symbol : public Object {
+// Integers beyond 64 bits, see numeric.h. Smaller ones are never stored this way.
+class BigNumber : public Object {
 public:
-    Symbol(std::string symbol) : symbol_(symbol){};
-    const std::string& GetName() const {
-        return symbol_;
+    static constexpr ObjectType kType = ObjectType::BIGNUMBER;
+
+    BigNumber(BigInt n) : Object(kType), number_(std::move(n)){};
+    const BigInt& GetValue() const {
+        return number_;
     };
 
 private:
-    std::string symbol_{};
+    friend class Collector;
+
+    BigInt number_;
 };
 
-class OpenParen : public Object {};
+// Fixnums have no object to point at, so As<Number> hands out this stand-in instead.
+class NumberView {
+public:
+    explicit NumberView(int64_t n) : number_(n){};
+    int64_t GetValue() const {
+        return number_;
+    };
+    const NumberView* operator->() const {
+        return this;
+    };
 
-class CloseParen : public Object {};
+private:
+    int64_t number_{};
+};
 
-class Dot : public Object {};
+class Symbol : public Object {
+public:
+    static constexpr ObjectType kType = ObjectType::SYMBOL;
 
-class Quote : public Object {};
+    Symbol(std::string_view symbol) : Object(kType), symbol_(Intern(symbol)){};
+    Symbol(const std::string* interned) : Object(kType), symbol_(interned){};
+    const std::string& GetName() const {
+        return *symbol_;
+    };
+    const std::string* GetInterned() const {
+        return symbol_;
+    };
+    bool operator==(const Symbol& other) const {
+        return symbol_ == other.symbol_;
+    };
+
+    // What the name resolves to as a builtin, remembered by the interpreter in the spare bytes
+    // of the header. 0 until it is resolved.
+    uint8_t GetBuiltin() const {
+        return builtin_;
+    };
+    void SetBuiltin(uint8_t builtin) const {
+        builtin_ = builtin;
+    };
+
+private:
+    mutable uint8_t builtin_ = 0;
+    const std::string* symbol_{};
+};
 
 class Cell : public Object {
 public:
-    Cell(std::shared_ptr<Object> ptr) : left_son_(ptr){};
-    Cell(std::shared_ptr<Object> ptr_l, std::shared_ptr<Object> ptr_r)
-        : left_son_(ptr_l), right_son_(ptr_r){};
-    std::shared_ptr<Object> GetFirst() const {
+    static constexpr ObjectType kType = ObjectType::CELL;
+
+    Cell(Value ptr) : Object(kType), left_son_(std::move(ptr)){};
+    Cell(Value ptr_l, Value ptr_r)
+        : Object(kType), left_son_(std::move(ptr_l)), right_son_(std::move(ptr_r)){};
+    ~Cell();
+    // Borrowed, valid while the cell is alive.
+    const Value& GetFirst() const {
         return left_son_;
     };
-    std::shared_ptr<Object> GetSecond() const {
+    const Value& GetSecond() const {
         return right_son_;
     };
+    // The only way to change a cell after it is built, and so to make a cycle.
+    void SetFirst(Value value) {
+        WriteBarrier(value);
+        left_son_ = std::move(value);
+    };
+    void SetSecond(Value value) {
+        WriteBarrier(value);
+        if (run_ || (flags_ & kInRun)) {
+            BreakRun();
+        }
+        right_son_ = std::move(value);
+    };
+
+    // Lists built by NewList are CDR-coded: their cells sit next to each other in memory, and
+    // each knows how many of the cells right after it are also the next ones in the list. Those
+    // are reached by pointer arithmetic instead of following second one cell at a time.
+    size_t GetRun() const {
+        return run_;
+    };
+
+    // The cell that many steps down the second slots, nullptr if the chain of cells ends first.
+    Cell* Advance(size_t steps) {
+        auto cell = this;
+        while (steps > 0) {
+            if (cell->run_) {
+                auto jump = std::min<size_t>(steps, cell->run_);
+                cell += jump;
+                steps -= jump;
+            } else if (cell->right_son_.IsObject() &&
+                       cell->right_son_.GetObject()->GetType() == kType) {
+                cell = static_cast<Cell*>(cell->right_son_.GetObject());
+                --steps;
+            } else {
+                return nullptr;
+            }
+        }
+        return cell;
+    };
 
 private:
-    std::shared_ptr<Object> left_son_{};
-    std::shared_ptr<Object> right_son_{};
+    friend class Collector;
+    friend class Closure;
+    friend Value NewList(std::span<Value> elements, Value tail);
+
+    static bool IsDeep(const Value& value);
+    static void Unlink(Value current);
+    void BreakRun();
+
+    uint16_t run_ = 0;
+    Value left_son_{};
+    Value right_son_{};
 };
 
+// A procedure made by lambda: its code, see bytecode.h, and the values of the variables of
+// enclosing lambdas it uses, copied when it was made.
+class Closure : public Object {
+public:
+    static constexpr ObjectType kType = ObjectType::CLOSURE;
+
+    Closure(std::shared_ptr<const Lambda> lambda, std::vector<Value> captured)
+        : Object(kType), lambda_(std::move(lambda)), captured_(std::move(captured)){};
+    ~Closure();
+    const std::shared_ptr<const Lambda>& GetLambda() const {
+        return lambda_;
+    };
+    const std::vector<Value>& GetCaptured() const {
+        return captured_;
+    };
+
+private:
+    friend class Collector;
+    friend class Cell;
+
+    std::shared_ptr<const Lambda> lambda_;
+    std::vector<Value> captured_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// All objects are created here: inside an ArenaScope they go to its arena, with a current
+// collector to its nursery, otherwise to the slabs of the heap.
+template <class T, class... Args>
+Value New(Args&&... args) {
+    T* object;
+    if (Arena* arena = GetCurrentArena()) {
+        object = new (arena->Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        object->flags_ |= Object::kInArena;
+    } else if (Collector* collector = GetCurrentCollector()) {
+        auto memory = AllocateYoung(collector, sizeof(T), alignof(T));
+        object = new (memory) T(std::forward<Args>(args)...);
+        object->flags_ |= Object::kInArena | Object::kYoung;
+    } else {
+        object = new (SlabAllocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+    return Value(object);
+}
+
+// A proper list of the elements, moved out of the span, ending in the tail. Its cells are
+// allocated in runs, in an arena, a nursery or on the heap alike.
+Value NewList(std::span<Value> elements, Value tail = nullptr);
+
+// The value with everything of it that lives in an arena copied to where New puts objects now.
+Value CopyToHeap(const Value& value);
+
+inline Value Value::Integer(int64_t value) {
+    if (value >= (INT64_MIN >> 1) && value <= (INT64_MAX >> 1)) {
+        Value result;
+        result.bits_ = (static_cast<uintptr_t>(value) << 1) | 1;
+        return result;
+    }
+    return New<Number>(value);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
-// Runtime type checking and convertion.
-// This can be helpful: https://en.cppreference.com/w/cpp/memory/shared_ptr/pointer_cast
+// Runtime type checking and convertion, both resolved by the type tag without touching
+// reference counts. Heap types come back as borrowed raw pointers, numbers as a NumberView.
 
 template <class T>
-std::shared_ptr<T> As(const std::shared_ptr<Object>& obj) {
-    return std::static_pointer_cast<T>(obj);
+auto As(const Value& obj) {
+    if constexpr (std::is_same_v<T, Number>) {
+        if (obj.IsFixnum()) {
+            return NumberView(obj.GetFixnum());
+        }
+        return NumberView(static_cast<Number*>(obj.GetObject())->GetValue());
+    } else {
+        return static_cast<T*>(obj.GetObject());
+    }
 };
 
 template <class T>
-bool Is(const std::shared_ptr<Object>& obj) {
-    if (std::dynamic_pointer_cast<T>(obj) == nullptr) {
-        return false;
+bool Is(const Value& obj) {
+    if constexpr (std::is_same_v<T, Number>) {
+        if (obj.IsFixnum()) {
+            return true;
+        }
     }
-    return true;
+    return obj.IsObject() && obj.GetObject()->GetType() == T::kType;
 };
+
+static_assert(sizeof(Object) == 8);
+static_assert(sizeof(Symbol) == 16);
+static_assert(sizeof(Cell) == 24);
+static_assert(sizeof(Closure) <= 64);
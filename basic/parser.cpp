@@ -1,58 +1,189 @@
 #include <parser.h>
+#include <char_scan.h>
+#include <numeric.h>
 
-std::shared_ptr<Object> Read(Tokenizer* tokenizer) {
-    if (tokenizer->IsEnd()) {
-        throw SyntaxError("Empty tokenizer");
-    }
-    auto token = tokenizer->GetToken();
-    if (ConstantToken* x = std::get_if<ConstantToken>(&token)) {
-        tokenizer->Next();
-        return std::make_shared<Number>(x->value);
+#include <utility>
+#include <vector>
+
+// An unfinished list or quote on the reader stack. Elements of all open lists share one
+// vector, a list owns the part of it starting at begin.
+struct ReadFrame {
+    enum class Kind { LIST, QUOTE };
+    enum class State { ELEMENTS, AFTER_DOT, AFTER_TAIL };
+
+    Kind kind;
+    size_t begin = 0;
+    State state = State::ELEMENTS;
+};
+
+// Pops the elements of the top list and builds it in one go, so every element costs O(1), no
+// cell has to be changed after it is built and the cells of the list end up next to each other.
+static Value CloseList(const ReadFrame& frame, std::vector<Value>* values) {
+    if (frame.state == ReadFrame::State::AFTER_DOT) {
+        throw SyntaxError("There should be an object after .");
     }
-    if (SymbolToken* x = std::get_if<SymbolToken>(&token)) {
-        tokenizer->Next();
-        return std::make_shared<Symbol>(x->name);
+    Value tail;
+    if (frame.state == ReadFrame::State::AFTER_TAIL) {
+        tail = std::move(values->back());
+        values->pop_back();
     }
-    if (BracketToken* x = std::get_if<BracketToken>(&token)) {
+    auto list = NewList(std::span(*values).subspan(frame.begin), std::move(tail));
+    values->resize(frame.begin);
+    return list;
+}
+
+Value Read(Tokenizer* tokenizer) {
+    std::vector<ReadFrame> frames;
+    std::vector<Value> values;
+    while (true) {
+        if (tokenizer->IsEnd()) {
+            throw SyntaxError("Empty tokenizer");
+        }
+        auto token = tokenizer->GetToken();
         tokenizer->Next();
-        if (*x == BracketToken::OPEN) {
-            return ReadLine(tokenizer);
+        Value datum;
+        if (ConstantToken* x = std::get_if<ConstantToken>(&token)) {
+            datum = Value::Integer(x->value);
+        } else if (BigConstantToken* x = std::get_if<BigConstantToken>(&token)) {
+            datum = FromBigInt(std::move(x->value));
+        } else if (SymbolToken* x = std::get_if<SymbolToken>(&token)) {
+            datum = New<Symbol>(x->name);
+        } else if (BooleanToken* x = std::get_if<BooleanToken>(&token)) {
+            datum = Value::Boolean(*x == BooleanToken::TRUE);
+        } else if (std::get_if<QuoteToken>(&token)) {
+            frames.push_back({ReadFrame::Kind::QUOTE});
+            continue;
+        } else if (std::get_if<DotToken>(&token)) {
+            if (frames.empty() || frames.back().kind != ReadFrame::Kind::LIST ||
+                frames.back().state != ReadFrame::State::ELEMENTS ||
+                values.size() == frames.back().begin) {
+                throw SyntaxError("Unexpected .");
+            }
+            frames.back().state = ReadFrame::State::AFTER_DOT;
+            continue;
+        } else if (std::get<BracketToken>(token) == BracketToken::OPEN) {
+            frames.push_back({ReadFrame::Kind::LIST, values.size()});
+            continue;
+        } else {
+            if (frames.empty() || frames.back().kind != ReadFrame::Kind::LIST) {
+                throw SyntaxError("Unexpected )");
+            }
+            datum = CloseList(frames.back(), &values);
+            frames.pop_back();
         }
-        return std::make_shared<Symbol>(")");
+
+        while (!frames.empty() && frames.back().kind == ReadFrame::Kind::QUOTE) {
+            datum = New<Cell>(New<Symbol>("quote"), New<Cell>(std::move(datum), nullptr));
+            frames.pop_back();
+        }
+        if (frames.empty()) {
+            return datum;
+        }
+        auto& list = frames.back();
+        if (list.state == ReadFrame::State::AFTER_TAIL) {
+            throw SyntaxError("There should be )");
+        }
+        if (list.state == ReadFrame::State::AFTER_DOT) {
+            list.state = ReadFrame::State::AFTER_TAIL;
+        }
+        values.push_back(std::move(datum));
     }
-    if (DotToken* x = std::get_if<DotToken>(&token)) {
-        tokenizer->Next();
-        return std::make_shared<Symbol>(".");
+}
+
+void IncrementalReader::Feed(std::string_view chunk) {
+    buffer_.erase(0, datum_begin_);
+    scanned_ -= datum_begin_;
+    datum_begin_ = 0;
+    buffer_ += chunk;
+    for (; scanned_ < buffer_.size(); ++scanned_) {
+        char x = buffer_[scanned_];
+        bool space = HasClass(static_cast<unsigned char>(x), kSpace);
+        if (in_atom_) {
+            if (!space && x != '(' && x != ')' && x != '\'') {
+                continue;
+            }
+            in_atom_ = false;
+            Emit(scanned_);
+        }
+        if (space) {
+            if (!in_datum_) {
+                datum_begin_ = scanned_ + 1;
+            }
+        } else if (x == '(') {
+            in_datum_ = true;
+            ++depth_;
+        } else if (x == ')') {
+            if (depth_ == 0) {
+                datum_begin_ = scanned_ + 1;
+                in_datum_ = false;
+                if (!error_) {
+                    error_ = std::make_exception_ptr(SyntaxError("Unexpected )"));
+                }
+            } else if (--depth_ == 0) {
+                Emit(scanned_ + 1);
+            }
+        } else if (x == '\'') {
+            in_datum_ = true;
+        } else if (depth_ == 0) {
+            in_datum_ = true;
+            in_atom_ = true;
+        }
     }
-    if (QuoteToken* x = std::get_if<QuoteToken>(&token)) {
-        tokenizer->Next();
-        return std::make_shared<Cell>(std::make_shared<Symbol>("quote"),
-                                      std::make_shared<Cell>(Read(tokenizer), nullptr));
+    ThrowIfFailed();
+}
+
+void IncrementalReader::Finish() {
+    if (in_atom_) {
+        in_atom_ = false;
+        Emit(buffer_.size());
     }
-    if (BooleanToken* x = std::get_if<BooleanToken>(&token)) {
-        tokenizer->Next();
-        if (*x == BooleanToken::TRUE) {
-            return std::make_shared<Symbol>("#t");
-        } else {
-            return std::make_shared<Symbol>("#f");
+    if (in_datum_) {
+        buffer_.clear();
+        scanned_ = datum_begin_ = 0;
+        depth_ = 0;
+        in_datum_ = false;
+        if (!error_) {
+            error_ = std::make_exception_ptr(SyntaxError("Unexpected end of input"));
         }
     }
-    tokenizer->Next();
-    return nullptr;
+    ThrowIfFailed();
 }
 
-std::shared_ptr<Object> ReadLine(Tokenizer* tokenizer) {
-    auto read = Read(tokenizer);
-    if (Is<Symbol>(read) && As<Symbol>(read)->GetName() == ")") {
-        return nullptr;
-    }
-    if (Is<Symbol>(read) && As<Symbol>(read)->GetName() == ".") {
-        auto new_read = Read(tokenizer);
-        auto close_brace = Read(tokenizer);
-        if (!Is<Symbol>(close_brace) || As<Symbol>(close_brace)->GetName() != ")") {
-            throw SyntaxError("There should be )");
+bool IncrementalReader::HasDatum() const {
+    return !ready_.empty();
+}
+
+Value IncrementalReader::TakeDatum() {
+    auto datum = std::move(ready_.front());
+    ready_.pop_front();
+    return datum;
+}
+
+int IncrementalReader::Depth() const {
+    return depth_;
+}
+
+// A broken datum is only remembered, the rest of the chunk is still read.
+void IncrementalReader::Emit(size_t end) {
+    std::string_view text(buffer_.data() + datum_begin_, end - datum_begin_);
+    datum_begin_ = end;
+    in_datum_ = false;
+    try {
+        Tokenizer tokenizer{text};
+        auto datum = Read(&tokenizer);
+        if (!tokenizer.IsEnd()) {
+            throw SyntaxError("Invalid syntax");
         }
-        return new_read;
+        ready_.push_back(std::move(datum));
+    } catch (const SyntaxError&) {
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+}
+
+void IncrementalReader::ThrowIfFailed() {
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
     }
-    return std::make_shared<Cell>(read, ReadLine(tokenizer));
 }
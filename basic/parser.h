@@ -1,13 +1,47 @@
 #pragma once
 
-#include <memory>
+#include <deque>
+#include <exception>
+#include <string>
+#include <string_view>
 
 #include "object.h"
 #include <tokenizer.h>
 #include <error.h>
 
-std::shared_ptr<Object> ReadLine(Tokenizer* tokenizer);
+// Reads one datum. Lists are built on an explicit stack, so neither the length of a list
+// nor its nesting depth is limited by the C++ stack.
+Value Read(Tokenizer* tokenizer);
 
-std::shared_ptr<Object> Read(Tokenizer* tokenizer);
+// Reads data from input that arrives in arbitrary chunks. Every complete top-level datum
+// is parsed as soon as its last char arrives. Paren depth and whether an atom is unfinished
+// are kept between calls, so the scan for datum ends goes over each byte once; the bytes of
+// a datum are then tokenized once more when it is read, and an unfinished one is kept until
+// it is complete.
+class IncrementalReader {
+public:
+    // Throws SyntaxError for the first malformed datum, after reading the whole chunk.
+    void Feed(std::string_view chunk);
 
-std::shared_ptr<Object> ReadLine(Tokenizer* tokenizer);
\ No newline at end of file
+    // No more input: completes a trailing atom and rejects an unfinished datum.
+    void Finish();
+
+    bool HasDatum() const;
+
+    Value TakeDatum();
+
+    int Depth() const;
+
+private:
+    void Emit(size_t end);
+    void ThrowIfFailed();
+
+    std::string buffer_;
+    size_t scanned_ = 0;
+    size_t datum_begin_ = 0;
+    int depth_ = 0;
+    bool in_datum_ = false;
+    bool in_atom_ = false;
+    std::deque<Value> ready_;
+    std::exception_ptr error_;
+};
@@ -0,0 +1,74 @@
+#include <reclaimer.h>
+
+Reclaimer::Reclaimer() : thread_([this] { Run(); }) {
+}
+
+Reclaimer::~Reclaimer() {
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+bool Reclaimer::IsOwned(const Value& root) {
+    std::vector<const Value*> pending{&root};
+    while (!pending.empty()) {
+        auto value = pending.back();
+        pending.pop_back();
+        if (!value->IsObject()) {
+            continue;
+        }
+        if (!value->IsUnique() || Is<Closure>(*value) ||
+            (value->GetObject()->flags_ & (Object::kInArena | Object::kTracked))) {
+            return false;
+        }
+        if (Is<Cell>(*value)) {
+            pending.push_back(&As<Cell>(*value)->GetSecond());
+            pending.push_back(&As<Cell>(*value)->GetFirst());
+        }
+    }
+    return true;
+}
+
+void Reclaimer::Retire(Value value) {
+    if (!value.IsObject() || !IsOwned(value)) {
+        return;
+    }
+    {
+        std::lock_guard lock{mutex_};
+        queue_.push_back(std::move(value));
+    }
+    wake_.notify_one();
+}
+
+void Reclaimer::Wait() {
+    std::unique_lock lock{mutex_};
+    idle_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+size_t Reclaimer::GetReclaimed() const {
+    std::lock_guard lock{mutex_};
+    return reclaimed_;
+}
+
+void Reclaimer::Run() {
+    std::vector<Value> batch;
+    std::unique_lock lock{mutex_};
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            break;
+        }
+        batch.swap(queue_);
+        busy_ = true;
+        lock.unlock();
+        auto count = batch.size();
+        batch.clear();
+        lock.lock();
+        busy_ = false;
+        reclaimed_ += count;
+        idle_.notify_all();
+    }
+}
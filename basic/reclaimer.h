@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "object.h"
+
+// Frees dead object graphs on a thread of its own, so that a caller dropping a big graph it
+// built on the heap doesn't pay for freeing it.
+//
+// Counts are not atomic, so a retired graph has to be the caller's alone: no object in it may
+// be shared with a value that is still in use. Retire walks the whole graph to check that, which
+// only reads it. A graph with an object that is shared, lives in an arena or a nursery, or is
+// tracked by a collector is released on the spot instead, those objects are not the reclaimer's
+// to free. So is one with a closure, its code holds constants shared with programs. The
+// interpreter retires definitions it drops to it, see Interpreter::SetReclaimer.
+class Reclaimer {
+public:
+    Reclaimer();
+
+    Reclaimer(const Reclaimer&) = delete;
+    Reclaimer& operator=(const Reclaimer&) = delete;
+
+    // Frees everything still queued before returning.
+    ~Reclaimer();
+
+    void Retire(Value value);
+
+    // Blocks until everything retired so far is freed.
+    void Wait();
+
+    // Graphs freed by the background thread.
+    size_t GetReclaimed() const;
+
+private:
+    // Whether the graph holds nothing but objects only it refers to.
+    static bool IsOwned(const Value& root);
+
+    void Run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::vector<Value> queue_;
+    bool busy_ = false;
+    bool stopping_ = false;
+    size_t reclaimed_ = 0;
+    std::thread thread_;
+};
@@ -1,8 +1,11 @@
 #include "scheme.h"
 
-std::shared_ptr<Object> ReadAll(const std::string& str) {
-    std::stringstream ss{str};
-    Tokenizer tokenizer{&ss};
+#include <array>
+#include <iterator>
+#include <optional>
+
+Value ReadAll(std::string_view str) {
+    Tokenizer tokenizer{str};
 
     auto obj = Read(&tokenizer);
     if (!tokenizer.IsEnd()) {
@@ -14,64 +17,72 @@ std::shared_ptr<Object> ReadAll(const std::string& str) {
     return obj;
 }
 
-void OutputFirst(std::shared_ptr<Object> tree, std::string& ans) {
-    if (tree == nullptr) {
+static void OutputAtom(const Value& atom, std::string& ans) {
+    if (atom == nullptr) {
         ans += "()";
-        return;
-    }
-    if (!Is<Cell>(tree)) {
-        if (Is<Number>(tree)) {
-            auto num = As<Number>(tree);
-            ans += std::to_string(num->GetValue());
-            return;
-        }
-        auto symb = As<Symbol>(tree);
-        ans += symb->GetName();
-        return;
+    } else if (IsInteger(atom)) {
+        ans += IntegerToString(atom);
+    } else if (atom.IsBoolean()) {
+        ans += atom.GetBoolean() ? "#t" : "#f";
+    } else if (Is<Closure>(atom)) {
+        ans += "#<procedure>";
+    } else {
+        ans += As<Symbol>(atom)->GetName();
     }
-    ans += '(';
-    OutputSecond(tree, ans);
-    ans += ')';
 }
 
-void OutputSecond(std::shared_ptr<Object> tree, std::string& ans) {
-    if (tree == nullptr) {
-        ans.pop_back();
-        return;
-    }
-    if (!Is<Cell>(tree)) {
-        if (Is<Number>(tree)) {
-            auto num = As<Number>(tree);
+// Prints the tree as OutputFirst does, or the rest of a list as OutputSecond does. Nested lists
+// are kept on an explicit stack, however deep they are.
+static void Output(const Value& tree, bool first, std::string& ans) {
+    // Rests of the lists around the value, innermost last. nullptr closes a list.
+    std::vector<const Value*> pending;
+    auto value = &tree;
+    while (true) {
+        if (Is<Cell>(*value)) {
+            if (first) {
+                ans += '(';
+                pending.push_back(nullptr);
+                first = false;
+            } else {
+                pending.push_back(&As<Cell>(*value)->GetSecond());
+                value = &As<Cell>(*value)->GetFirst();
+                first = true;
+            }
+            continue;
+        }
+        if (first) {
+            OutputAtom(*value, ans);
+        } else if (*value == nullptr) {
+            ans.pop_back();
+        } else {
             ans += ". ";
-            ans += std::to_string(num->GetValue());
+            OutputAtom(*value, ans);
+        }
+        while (!pending.empty() && !pending.back()) {
+            ans += ')';
+            pending.pop_back();
+        }
+        if (pending.empty()) {
             return;
         }
-        auto symb = As<Symbol>(tree);
-        ans += ". ";
-        ans += symb->GetName();
-        return;
+        ans += ' ';
+        value = pending.back();
+        pending.pop_back();
+        first = false;
     }
-    auto pair = As<Cell>(tree);
-    OutputFirst(pair->GetFirst(), ans);
-    ans += ' ';
-    OutputSecond(pair->GetSecond(), ans);
 }
 
-class Function {
-public:
-    virtual ~Function() = default;
-    virtual std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) = 0;
-    virtual bool IsBoolean() {
-        return false;
-    }
-    virtual bool IsQuote() {
-        return false;
-    }
-};
+void OutputFirst(const Value& tree, std::string& ans) {
+    Output(tree, true, ans);
+}
+
+void OutputSecond(const Value& tree, std::string& ans) {
+    Output(tree, false, ans);
+}
 
 class QuoteFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr) {
             return ptr;
         }
@@ -87,574 +98,340 @@ public:
 
 class IsNumberFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         auto pair = As<Cell>(ptr);
         if (pair->GetSecond() != nullptr) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         if (pair->GetFirst() == nullptr) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
-        if (Is<Number>(pair->GetFirst())) {
-            return std::make_shared<Symbol>("#t");
+        if (IsInteger(pair->GetFirst())) {
+            return Value::Boolean(true);
         }
-        return std::make_shared<Symbol>("#f");
+        return Value::Boolean(false);
     }
 };
 
-class EqualFunction : public Function {
-public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        return Helper(ptr);
+// What the arithmetic builtins check of every argument, in this order.
+static void CheckInteger(const Value& value, const char* invalid) {
+    if (value == nullptr || Is<Cell>(value)) {
+        throw RuntimeError("Invalid operands");
+    }
+    if (!IsInteger(value)) {
+        throw RuntimeError(invalid);
     }
+}
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return std::make_shared<Symbol>("#t");
-        }
-        std::vector<std::shared_ptr<Object>> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
-        }
-        bool ans = true;
-        for (size_t i = 0; i < nums.size() - 1; ++i) {
-            if (Is<Number>(nums[i]) && Is<Number>(nums[i + 1])) {
-                if (As<Number>(nums[i])->GetValue() != As<Number>(nums[i + 1])->GetValue()) {
-                    ans = false;
-                    break;
-                }
-                continue;
-            }
+// The arguments the tree walker passes to a builtin, each one checked in turn; an improper tail
+// counts as one more. Walks the list in a loop, however long it is.
+template <class Check>
+static void CollectArguments(const Value& ptr, std::vector<Value>& nums, Check check) {
+    const Value* rest = &ptr;
+    while (Is<Cell>(*rest)) {
+        auto pair = As<Cell>(*rest);
+        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
             throw RuntimeError("Invalid operands");
         }
-        if (ans) {
-            return std::make_shared<Symbol>("#t");
-        }
-        return std::make_shared<Symbol>("#f");
+        check(pair->GetFirst());
+        nums.push_back(pair->GetFirst());
+        rest = &pair->GetSecond();
+    }
+    if (*rest != nullptr) {
+        check(*rest);
+        nums.push_back(*rest);
     }
+}
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<std::shared_ptr<Object>>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            nums.push_back(ptr);
-            return;
+// Whether every two neighbours are in the order, which stops being checked at the first pair
+// that isn't.
+template <class Holds>
+static Value CompareChain(std::span<Value> args, Holds holds) {
+    for (const auto& value : args) {
+        if (value == nullptr || Is<Cell>(value)) {
+            throw RuntimeError("Invalid operands");
         }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
+    }
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (!IsInteger(args[i]) || !IsInteger(args[i + 1])) {
             throw RuntimeError("Invalid operands");
         }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+        if (!holds(Compare(args[i], args[i + 1]))) {
+            return Value::Boolean(false);
+        }
+    }
+    return Value::Boolean(true);
+}
+
+class EqualFunction : public Function {
+public:
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value&) {});
+        return Call(nums);
+    }
+
+    Value Call(std::span<Value> args) override {
+        return CompareChain(args, [](int order) { return order == 0; });
+    }
+
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class MoreFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        return Helper(ptr);
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value&) {});
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return std::make_shared<Symbol>("#t");
-        }
-        std::vector<std::shared_ptr<Object>> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
-        }
-        bool ans = true;
-        for (size_t i = 0; i < nums.size() - 1; ++i) {
-            if (Is<Number>(nums[i]) && Is<Number>(nums[i + 1])) {
-                if (As<Number>(nums[i])->GetValue() <= As<Number>(nums[i + 1])->GetValue()) {
-                    ans = false;
-                    break;
-                }
-                continue;
-            }
-            throw RuntimeError("Invalid operands");
-        }
-        if (ans) {
-            return std::make_shared<Symbol>("#t");
-        }
-        return std::make_shared<Symbol>("#f");
+    Value Call(std::span<Value> args) override {
+        return CompareChain(args, [](int order) { return order > 0; });
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<std::shared_ptr<Object>>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            nums.push_back(ptr);
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class LessFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        return Helper(ptr);
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value&) {});
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return std::make_shared<Symbol>("#t");
-        }
-        std::vector<std::shared_ptr<Object>> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
-        }
-        bool ans = true;
-        for (size_t i = 0; i < nums.size() - 1; ++i) {
-            if (Is<Number>(nums[i]) && Is<Number>(nums[i + 1])) {
-                if (As<Number>(nums[i])->GetValue() >= As<Number>(nums[i + 1])->GetValue()) {
-                    ans = false;
-                    break;
-                }
-                continue;
-            }
-            throw RuntimeError("Invalid operands");
-        }
-        if (ans) {
-            return std::make_shared<Symbol>("#t");
-        }
-        return std::make_shared<Symbol>("#f");
+    Value Call(std::span<Value> args) override {
+        return CompareChain(args, [](int order) { return order < 0; });
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<std::shared_ptr<Object>>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            nums.push_back(ptr);
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class MoreOrEqualFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        return Helper(ptr);
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value&) {});
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return std::make_shared<Symbol>("#t");
-        }
-        std::vector<std::shared_ptr<Object>> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
-        }
-        bool ans = true;
-        for (size_t i = 0; i < nums.size() - 1; ++i) {
-            if (Is<Number>(nums[i]) && Is<Number>(nums[i + 1])) {
-                if (As<Number>(nums[i])->GetValue() < As<Number>(nums[i + 1])->GetValue()) {
-                    ans = false;
-                    break;
-                }
-                continue;
-            }
-            throw RuntimeError("Invalid operands");
-        }
-        if (ans) {
-            return std::make_shared<Symbol>("#t");
-        }
-        return std::make_shared<Symbol>("#f");
+    Value Call(std::span<Value> args) override {
+        return CompareChain(args, [](int order) { return order >= 0; });
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<std::shared_ptr<Object>>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            nums.push_back(ptr);
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class LessOrEqualFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        return Helper(ptr);
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value&) {});
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return std::make_shared<Symbol>("#t");
-        }
-        std::vector<std::shared_ptr<Object>> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
-        }
-        bool ans = true;
-        for (size_t i = 0; i < nums.size() - 1; ++i) {
-            if (Is<Number>(nums[i]) && Is<Number>(nums[i + 1])) {
-                if (As<Number>(nums[i])->GetValue() > As<Number>(nums[i + 1])->GetValue()) {
-                    ans = false;
-                    break;
-                }
-                continue;
-            }
-            throw RuntimeError("Invalid operands");
-        }
-        if (ans) {
-            return std::make_shared<Symbol>("#t");
-        }
-        return std::make_shared<Symbol>("#f");
+    Value Call(std::span<Value> args) override {
+        return CompareChain(args, [](int order) { return order <= 0; });
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<std::shared_ptr<Object>>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            nums.push_back(ptr);
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class SumFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        auto helper = Helper(ptr);
-        if (helper == nullptr || !Is<Number>(helper)) {
-            throw RuntimeError("Sth went wrong, it is not a number");
-        }
-        auto num = As<Number>(helper);
-        return num;
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value& value) {
+            CheckInteger(value, "Invalid argument to + func");
+        });
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return std::make_shared<Number>(0);
+    Value Call(std::span<Value> args) override {
+        for (const auto& value : args) {
+            CheckInteger(value, "Invalid argument to + func");
         }
-        std::vector<int64_t> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
+        auto ans = Value::Integer(0);
+        for (const auto& value : args) {
+            ans = Add(ans, value);
         }
-        int64_t ans = 0;
-        for (const auto& value : nums) {
-            ans += value;
-        }
-        return std::make_shared<Number>(ans);
+        return ans;
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<int64_t>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            if (!Is<Number>(ptr)) {
-                throw RuntimeError("Invalid argument to + func");
-            }
-            auto num = As<Number>(ptr);
-            nums.push_back(num->GetValue());
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class SubstitutionFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        auto helper = Helper(ptr);
-        if (helper == nullptr || !Is<Number>(helper)) {
-            throw RuntimeError("Sth went wrong, it is not a number");
-        }
-        auto num = As<Number>(helper);
-        return num;
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value& value) {
+            CheckInteger(value, "Invalid argument to - func");
+        });
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return nullptr;
+    Value Call(std::span<Value> args) override {
+        if (args.empty()) {
+            throw RuntimeError("Sth went wrong, it is not a number");
         }
-        std::vector<int64_t> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
+        for (const auto& value : args) {
+            CheckInteger(value, "Invalid argument to - func");
         }
-        int64_t ans = nums[0];
-        for (size_t i = 1; i < nums.size(); ++i) {
-            ans -= nums[i];
+        auto ans = args[0];
+        for (size_t i = 1; i < args.size(); ++i) {
+            ans = Subtract(ans, args[i]);
         }
-        return std::make_shared<Number>(ans);
+        return ans;
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<int64_t>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            if (!Is<Number>(ptr)) {
-                throw RuntimeError("Invalid argument to - func");
-            }
-            auto num = As<Number>(ptr);
-            nums.push_back(num->GetValue());
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class MultiplicationFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        auto helper = Helper(ptr);
-        if (helper == nullptr || !Is<Number>(helper)) {
-            throw RuntimeError("Sth went wrong, it is not a number");
-        }
-        auto num = As<Number>(helper);
-        return num;
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value& value) {
+            CheckInteger(value, "Invalid argument to * func");
+        });
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return std::make_shared<Number>(1);
-        }
-        std::vector<int64_t> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
+    Value Call(std::span<Value> args) override {
+        for (const auto& value : args) {
+            CheckInteger(value, "Invalid argument to * func");
         }
-        int64_t ans = 1;
-        for (const auto& value : nums) {
-            ans *= value;
+        auto ans = Value::Integer(1);
+        for (const auto& value : args) {
+            ans = Multiply(ans, value);
         }
-        return std::make_shared<Number>(ans);
+        return ans;
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<int64_t>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            if (!Is<Number>(ptr)) {
-                throw RuntimeError("Invalid argument to * func");
-            }
-            auto num = As<Number>(ptr);
-            nums.push_back(num->GetValue());
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class DivideFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        auto helper = Helper(ptr);
-        if (helper == nullptr || !Is<Number>(helper)) {
-            throw RuntimeError("Sth went wrong, it is not a number");
-        }
-        auto num = As<Number>(helper);
-        return num;
-    }
-
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return nullptr;
-        }
-        std::vector<int64_t> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
-        }
-        int64_t ans = nums[0];
-        for (size_t i = 1; i < nums.size(); ++i) {
-            ans /= nums[i];
-        }
-        return std::make_shared<Number>(ans);
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value& value) {
+            CheckInteger(value, "Invalid argument to / func");
+            if (Is<Number>(value) && As<Number>(value)->GetValue() == 0) {
+                throw RuntimeError("Divididng by zero");
+            }
+        });
+        return Call(nums);
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<int64_t>& nums) {
-        if (ptr == nullptr) {
-            return;
+    Value Call(std::span<Value> args) override {
+        if (args.empty()) {
+            throw RuntimeError("Sth went wrong, it is not a number");
         }
-        if (!Is<Cell>(ptr)) {
-            if (!Is<Number>(ptr)) {
-                throw RuntimeError("Invalid argument to / func");
-            }
-            auto num = As<Number>(ptr);
-            if (num->GetValue() == 0) {
+        for (const auto& value : args) {
+            CheckInteger(value, "Invalid argument to / func");
+            if (Is<Number>(value) && As<Number>(value)->GetValue() == 0) {
                 throw RuntimeError("Divididng by zero");
             }
-            nums.push_back(num->GetValue());
-            return;
         }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
+        auto ans = args[0];
+        for (size_t i = 1; i < args.size(); ++i) {
+            ans = Quotient(ans, args[i]);
         }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+        return ans;
+    }
+
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class MaxFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        auto helper = Helper(ptr);
-        if (helper == nullptr || !Is<Number>(helper)) {
-            throw RuntimeError("Sth went wrong, it is not a number");
-        }
-        auto num = As<Number>(helper);
-        return num;
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value& value) {
+            CheckInteger(value, "Invalid argument to * func");
+        });
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return nullptr;
+    Value Call(std::span<Value> args) override {
+        if (args.empty()) {
+            throw RuntimeError("Sth went wrong, it is not a number");
         }
-        std::vector<int64_t> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
+        for (const auto& value : args) {
+            CheckInteger(value, "Invalid argument to * func");
         }
-        int64_t ans = std::numeric_limits<int64_t>::min();
-        for (const auto& value : nums) {
-            ans = std::max(ans, value);
+        auto ans = args[0];
+        for (const auto& value : args) {
+            if (Compare(value, ans) > 0) {
+                ans = value;
+            }
         }
-        return std::make_shared<Number>(ans);
+        return ans;
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<int64_t>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            if (!Is<Number>(ptr)) {
-                throw RuntimeError("Invalid argument to * func");
-            }
-            auto num = As<Number>(ptr);
-            nums.push_back(num->GetValue());
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class MinFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
-        auto helper = Helper(ptr);
-        if (helper == nullptr || !Is<Number>(helper)) {
-            throw RuntimeError("Sth went wrong, it is not a number");
-        }
-        auto num = As<Number>(helper);
-        return num;
+    Value Do(const Value& ptr) override {
+        std::vector<Value> nums;
+        CollectArguments(ptr, nums, [](const Value& value) {
+            CheckInteger(value, "Invalid argument to * func");
+        });
+        return Call(nums);
     }
 
-private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return nullptr;
+    Value Call(std::span<Value> args) override {
+        if (args.empty()) {
+            throw RuntimeError("Sth went wrong, it is not a number");
         }
-        std::vector<int64_t> nums;
-        FullVector(ptr, nums);
-        if (nums.empty()) {
-            throw RuntimeError("No operands");
+        for (const auto& value : args) {
+            CheckInteger(value, "Invalid argument to * func");
         }
-        int64_t ans = std::numeric_limits<int64_t>::max();
-        for (const auto& value : nums) {
-            ans = std::min(ans, value);
+        auto ans = args[0];
+        for (const auto& value : args) {
+            if (Compare(value, ans) < 0) {
+                ans = value;
+            }
         }
-        return std::make_shared<Number>(ans);
+        return ans;
     }
 
-    void FullVector(std::shared_ptr<Object> ptr, std::vector<int64_t>& nums) {
-        if (ptr == nullptr) {
-            return;
-        }
-        if (!Is<Cell>(ptr)) {
-            if (!Is<Number>(ptr)) {
-                throw RuntimeError("Invalid argument to * func");
-            }
-            auto num = As<Number>(ptr);
-            nums.push_back(num->GetValue());
-            return;
-        }
-        auto pair = As<Cell>(ptr);
-        if (pair->GetFirst() == nullptr || Is<Cell>(pair->GetFirst())) {
-            throw RuntimeError("Invalid operands");
-        }
-        FullVector(pair->GetFirst(), nums);
-        FullVector(pair->GetSecond(), nums);
+    bool IsArithmetic() override {
+        return true;
     }
 };
 
 class AbsFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
             throw RuntimeError("No input");
         }
@@ -665,34 +442,28 @@ public:
         if (pair->GetFirst() == nullptr) {
             throw RuntimeError("Invalid operands");
         }
-        if (Is<Number>(pair->GetFirst())) {
-            return std::make_shared<Number>(std::abs(As<Number>(pair->GetFirst())->GetValue()));
+        if (IsInteger(pair->GetFirst())) {
+            return Abs(pair->GetFirst());
         }
         throw RuntimeError("Invalid operands");
     }
 };
 
 class IsBooleanFunction : public Function {
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         auto pair = As<Cell>(ptr);
         if (pair->GetSecond() != nullptr || pair->GetFirst() == nullptr) {
-            return std::make_shared<Symbol>("#f");
-        }
-        if (Is<Symbol>(pair->GetFirst())) {
-            auto symb = As<Symbol>(pair->GetFirst());
-            if (symb->GetName() == "#t" || symb->GetName() == "#f") {
-                return std::make_shared<Symbol>("#t");
-            }
+            return Value::Boolean(false);
         }
-        return std::make_shared<Symbol>("#f");
+        return Value::Boolean(pair->GetFirst().IsBoolean());
     }
 };
 
 class NotFunctioon : public Function {
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
             throw RuntimeError("No operands for no-func");
         }
@@ -701,21 +472,15 @@ class NotFunctioon : public Function {
             throw RuntimeError("Invalid operands");
         }
         if (pair->GetFirst() == nullptr) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
-        if (Is<Symbol>(pair->GetFirst())) {
-            auto symb = As<Symbol>(pair->GetFirst());
-            if (symb->GetName() == "#f") {
-                return std::make_shared<Symbol>("#t");
-            }
-        }
-        return std::make_shared<Symbol>("#f");
+        return Value::Boolean(pair->GetFirst().IsFalse());
     }
 };
 
 class AndFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         auto helper = Helper(ptr);
         if (helper == nullptr) {
             throw RuntimeError("Sth went wrong, it is not a number");
@@ -728,12 +493,12 @@ public:
     }
 
 private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
+    Value Helper(const Value& ptr) {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
-            return std::make_shared<Symbol>("#t");
+            return Value::Boolean(true);
         }
-        std::shared_ptr<Object> ans = std::make_shared<Symbol>("#t");
-        std::shared_ptr<Object> pair = As<Cell>(ptr);
+        Value ans = Value::Boolean(true);
+        Value pair = As<Cell>(ptr);
         while (pair != nullptr) {
             if (!Is<Cell>(pair)) {
                 auto first = RealCount(pair);
@@ -741,19 +506,8 @@ private:
                     throw RuntimeError("Invalid syntax");
                 }
                 auto value = first.first;
-                if (Is<Symbol>(value)) {
-                    auto symb = As<Symbol>(value);
-                    if (symb->GetName() == "#f") {
-                        ans = std::make_shared<Symbol>("#f");
-                        return ans;
-                    } else {
-                        ans = std::make_shared<Symbol>(symb->GetName());
-                        return ans;
-                    }
-                }
-                if (Is<Number>(value)) {
-                    ans = std::make_shared<Number>(As<Number>(value)->GetValue());
-                    return ans;
+                if (value.IsBoolean() || Is<Symbol>(value) || IsInteger(value)) {
+                    return value;
                 }
             }
             auto rpair = As<Cell>(pair);
@@ -765,23 +519,10 @@ private:
             if (value == nullptr) {
                 throw RuntimeError("Invalid operands");
             }
-            if (Is<Symbol>(value)) {
-                auto symb = As<Symbol>(value);
-                if (symb->GetName() == "#f") {
-                    ans = std::make_shared<Symbol>("#f");
-                    return ans;
-                } else {
-                    ans = std::make_shared<Symbol>(symb->GetName());
-                    pair = rpair->GetSecond();
-                    continue;
-                }
-            }
-            if (Is<Number>(value)) {
-                ans = std::make_shared<Number>(As<Number>(value)->GetValue());
-                pair = rpair->GetSecond();
-                continue;
+            if (value.IsFalse()) {
+                return value;
             }
-            ans = std::make_shared<Cell>(As<Cell>(value)->GetFirst(), As<Cell>(value)->GetSecond());
+            ans = value;
             pair = rpair->GetSecond();
         }
         return ans;
@@ -790,7 +531,7 @@ private:
 
 class OrFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         auto helper = Helper(ptr);
         if (helper == nullptr) {
             throw RuntimeError("Sth went wrong, it is not a number");
@@ -803,12 +544,12 @@ public:
     }
 
 private:
-    std::shared_ptr<Object> Helper(std::shared_ptr<Object> ptr) {
+    Value Helper(const Value& ptr) {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
-        std::shared_ptr<Object> ans = std::make_shared<Symbol>("#f");
-        std::shared_ptr<Object> pair = As<Cell>(ptr);
+        Value ans = Value::Boolean(false);
+        Value pair = As<Cell>(ptr);
         while (pair != nullptr) {
             if (!Is<Cell>(pair)) {
                 auto first = RealCount(pair);
@@ -816,11 +557,8 @@ private:
                     throw RuntimeError("Invalid syntax");
                 }
                 auto value = first.first;
-                if (Is<Symbol>(value)) {
-                    auto symb = As<Symbol>(value);
-                    if (symb->GetName() == "#f") {
-                        return ans;
-                    }
+                if (value.IsFalse()) {
+                    return ans;
                 }
                 return value;
             }
@@ -833,12 +571,9 @@ private:
             if (value == nullptr) {
                 throw RuntimeError("Invalid operands");
             }
-            if (Is<Symbol>(value)) {
-                auto symb = As<Symbol>(value);
-                if (symb->GetName() == "#f") {
-                    pair = rpair->GetSecond();
-                    continue;
-                }
+            if (value.IsFalse()) {
+                pair = rpair->GetSecond();
+                continue;
             }
             return value;
         }
@@ -848,14 +583,14 @@ private:
 
 class IsPairFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         auto pair = As<Cell>(ptr);
         if (pair->GetSecond() != nullptr || pair->GetFirst() == nullptr ||
             !Is<Cell>(pair->GetFirst())) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         pair = As<Cell>(pair->GetFirst());
         if (pair->GetFirst() == nullptr) {
@@ -863,60 +598,69 @@ public:
         }
         if (!Is<Cell>(pair->GetFirst()) && pair->GetSecond() != nullptr &&
             !Is<Cell>(pair->GetSecond())) {
-            return std::make_shared<Symbol>("#t");
+            return Value::Boolean(true);
         }
         if (!Is<Cell>(pair->GetFirst()) && pair->GetSecond() != nullptr &&
             Is<Cell>(pair->GetSecond()) && !Is<Cell>(As<Cell>(pair->GetSecond())->GetFirst()) &&
             As<Cell>(pair->GetSecond())->GetSecond() == nullptr) {
-            return std::make_shared<Symbol>("#t");
+            return Value::Boolean(true);
         }
-        return std::make_shared<Symbol>("#f");
+        return Value::Boolean(false);
     }
 };
 
 class IsNullFunctioon : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         auto pair = As<Cell>(ptr);
         if (pair->GetFirst() == nullptr && pair->GetSecond() == nullptr) {
-            return std::make_shared<Symbol>("#t");
+            return Value::Boolean(true);
         }
-        return std::make_shared<Symbol>("#f");
+        return Value::Boolean(false);
     }
 };
 
+// Skips whole runs of cells at a time. -1 if the list is not proper.
+static int64_t ListLength(const Value& list) {
+    int64_t length = 0;
+    auto rest = &list;
+    while (Is<Cell>(*rest)) {
+        auto cell = As<Cell>(*rest);
+        length += cell->GetRun() + 1;
+        rest = &cell->Advance(cell->GetRun())->GetSecond();
+    }
+    return *rest == nullptr ? length : -1;
+}
+
 class IsListFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         auto pair = As<Cell>(ptr);
         if (pair->GetSecond() != nullptr) {
-            return std::make_shared<Symbol>("#f");
+            return Value::Boolean(false);
         }
         auto ptr_check = pair->GetFirst();
         if (Helper(ptr_check)) {
-            return std::make_shared<Symbol>("#t");
+            return Value::Boolean(true);
         }
-        return std::make_shared<Symbol>("#f");
+        return Value::Boolean(false);
     }
 
 private:
-    bool Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return true;
-        }
-        return Is<Cell>(ptr) && Helper(As<Cell>(ptr)->GetSecond());
+    bool Helper(const Value& ptr) {
+        return ListLength(ptr) >= 0;
     }
 };
 
 class ConsFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
             throw RuntimeError("Invalid operands");
         }
@@ -928,12 +672,12 @@ public:
             Is<Cell>(As<Cell>(pair->GetSecond())->GetFirst())) {
             throw RuntimeError("Invalid operands");
         }
-        return std::make_shared<Cell>(pair->GetFirst(), As<Cell>(pair->GetSecond())->GetFirst());
+        return New<Cell>(pair->GetFirst(), As<Cell>(pair->GetSecond())->GetFirst());
     }
 };
 
 class CarFunction : public Function {
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
             throw RuntimeError("Invalid operands");
         }
@@ -949,7 +693,7 @@ class CarFunction : public Function {
 
 class CdrFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
             throw RuntimeError("Invalid operands");
         }
@@ -965,7 +709,7 @@ public:
 
 class ListFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (Helper(ptr)) {
             return ptr;
         }
@@ -973,17 +717,14 @@ public:
     }
 
 private:
-    bool Helper(std::shared_ptr<Object> ptr) {
-        if (ptr == nullptr) {
-            return true;
-        }
-        return Is<Cell>(ptr) && Helper(As<Cell>(ptr)->GetSecond());
+    bool Helper(const Value& ptr) {
+        return ListLength(ptr) >= 0;
     }
 };
 
 class ListRefFunction : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
             throw RuntimeError("Invalid operands");
         }
@@ -998,13 +739,9 @@ public:
         if (!Is<Cell>(pair->GetFirst()) || ind < 0) {
             throw RuntimeError("Invalid operands");
         }
-        auto list = As<Cell>(pair->GetFirst());
-        while (ind > 0) {
-            if (list->GetSecond() == nullptr || !Is<Cell>(list->GetSecond())) {
-                throw RuntimeError("Invalid operands");
-            }
-            list = As<Cell>(list->GetSecond());
-            --ind;
+        auto list = As<Cell>(pair->GetFirst())->Advance(ind);
+        if (!list) {
+            throw RuntimeError("Invalid operands");
         }
         return list->GetFirst();
     }
@@ -1012,7 +749,7 @@ public:
 
 class ListTail : public Function {
 public:
-    std::shared_ptr<Object> Do(std::shared_ptr<Object> ptr) override {
+    Value Do(const Value& ptr) override {
         if (ptr == nullptr || !Is<Cell>(ptr)) {
             throw RuntimeError("Invalid operands");
         }
@@ -1027,79 +764,185 @@ public:
         if (!Is<Cell>(pair->GetFirst()) || ind < 0) {
             throw RuntimeError("Invalid operands");
         }
-        --ind;
-        auto list = As<Cell>(pair->GetFirst());
-        while (ind > 0) {
-            if (list->GetSecond() == nullptr || !Is<Cell>(list->GetSecond())) {
-                throw RuntimeError("Invalid operands");
-            }
-            list = As<Cell>(list->GetSecond());
-            --ind;
+        auto list = As<Cell>(pair->GetFirst())->Advance(ind > 0 ? ind - 1 : 0);
+        if (!list) {
+            throw RuntimeError("Invalid operands");
         }
         return list->GetSecond();
     }
 };
 
-std::unique_ptr<Function> FunctionCreator(const std::string& func_string) {
-    if (func_string == "quote") {
-        return std::make_unique<QuoteFunction>();
-    } else if (func_string == "number?") {
-        return std::make_unique<IsNumberFunction>();
-    } else if (func_string == "=") {
-        return std::make_unique<EqualFunction>();
-    } else if (func_string == ">") {
-        return std::make_unique<MoreFunction>();
-    } else if (func_string == "<") {
-        return std::make_unique<LessFunction>();
-    } else if (func_string == ">=") {
-        return std::make_unique<MoreOrEqualFunction>();
-    } else if (func_string == "<=") {
-        return std::make_unique<LessOrEqualFunction>();
-    } else if (func_string == "+") {
-        return std::make_unique<SumFunction>();
-    } else if (func_string == "-") {
-        return std::make_unique<SubstitutionFunction>();
-    } else if (func_string == "*") {
-        return std::make_unique<MultiplicationFunction>();
-    } else if (func_string == "/") {
-        return std::make_unique<DivideFunction>();
-    } else if (func_string == "max") {
-        return std::make_unique<MaxFunction>();
-    } else if (func_string == "min") {
-        return std::make_unique<MinFunction>();
-    } else if (func_string == "abs") {
-        return std::make_unique<AbsFunction>();
-    } else if (func_string == "boolean?") {
-        return std::make_unique<IsBooleanFunction>();
-    } else if (func_string == "not") {
-        return std::make_unique<NotFunctioon>();
-    } else if (func_string == "and") {
-        return std::make_unique<AndFunction>();
-    } else if (func_string == "or") {
-        return std::make_unique<OrFunction>();
-    } else if (func_string == "pair?") {
-        return std::make_unique<IsPairFunction>();
-    } else if (func_string == "null?") {
-        return std::make_unique<IsNullFunctioon>();
-    } else if (func_string == "list?") {
-        return std::make_unique<IsListFunction>();
-    } else if (func_string == "cons") {
-        return std::make_unique<ConsFunction>();
-    } else if (func_string == "car") {
-        return std::make_unique<CarFunction>();
-    } else if (func_string == "cdr") {
-        return std::make_unique<CdrFunction>();
-    } else if (func_string == "list") {
-        return std::make_unique<ListFunction>();
-    } else if (func_string == "list-ref") {
-        return std::make_unique<ListRefFunction>();
-    } else if (func_string == "list-tail") {
-        return std::make_unique<ListTail>();
-    }
-    return nullptr;
+// Exactly `count` integers, or throws RuntimeError.
+static std::vector<Value> IntegerArguments(const Value& ptr, size_t count) {
+    std::vector<Value> args;
+    auto rest = ptr;
+    while (rest != nullptr && Is<Cell>(rest) && args.size() < count) {
+        auto pair = As<Cell>(rest);
+        if (!IsInteger(pair->GetFirst())) {
+            throw RuntimeError("Invalid operands");
+        }
+        args.push_back(pair->GetFirst());
+        rest = pair->GetSecond();
+    }
+    if (args.size() != count || rest != nullptr) {
+        throw RuntimeError("Invalid operands");
+    }
+    return args;
+}
+
+class ExptFunction : public Function {
+public:
+    Value Do(const Value& ptr) override {
+        auto args = IntegerArguments(ptr, 2);
+        return Expt(args[0], args[1]);
+    }
+};
+
+class ModularExptFunction : public Function {
+public:
+    Value Do(const Value& ptr) override {
+        auto args = IntegerArguments(ptr, 3);
+        return ModularExpt(args[0], args[1], args[2]);
+    }
+};
+
+class LengthFunction : public Function {
+public:
+    Value Do(const Value& ptr) override {
+        if (ptr == nullptr || !Is<Cell>(ptr) || As<Cell>(ptr)->GetSecond() != nullptr) {
+            throw RuntimeError("Invalid operands");
+        }
+        auto length = ListLength(As<Cell>(ptr)->GetFirst());
+        if (length < 0) {
+            throw RuntimeError("Invalid operands");
+        }
+        return Value::Integer(length);
+    }
+};
+
+// Builtins keep no state, so each is one object living as long as the program.
+template <class F>
+static Function* Instance() {
+    static F function;
+    return &function;
+}
+
+struct Builtin {
+    std::string_view name;
+    Function* (*get)();
+};
+
+static constexpr Builtin kBuiltins[] = {
+    {"quote", Instance<QuoteFunction>},
+    {"number?", Instance<IsNumberFunction>},
+    {"=", Instance<EqualFunction>},
+    {">", Instance<MoreFunction>},
+    {"<", Instance<LessFunction>},
+    {">=", Instance<MoreOrEqualFunction>},
+    {"<=", Instance<LessOrEqualFunction>},
+    {"+", Instance<SumFunction>},
+    {"-", Instance<SubstitutionFunction>},
+    {"*", Instance<MultiplicationFunction>},
+    {"/", Instance<DivideFunction>},
+    {"max", Instance<MaxFunction>},
+    {"min", Instance<MinFunction>},
+    {"abs", Instance<AbsFunction>},
+    {"expt", Instance<ExptFunction>},
+    {"modular-expt", Instance<ModularExptFunction>},
+    {"boolean?", Instance<IsBooleanFunction>},
+    {"not", Instance<NotFunctioon>},
+    {"and", Instance<AndFunction>},
+    {"or", Instance<OrFunction>},
+    {"pair?", Instance<IsPairFunction>},
+    {"null?", Instance<IsNullFunctioon>},
+    {"list?", Instance<IsListFunction>},
+    {"cons", Instance<ConsFunction>},
+    {"car", Instance<CarFunction>},
+    {"cdr", Instance<CdrFunction>},
+    {"list", Instance<ListFunction>},
+    {"list-ref", Instance<ListRefFunction>},
+    {"list-tail", Instance<ListTail>},
+    {"length", Instance<LengthFunction>},
+};
+
+static constexpr size_t kBuiltinCount = std::size(kBuiltins);
+// Symbol::GetBuiltin values besides index + 1.
+static constexpr uint8_t kUnresolved = 0;
+static constexpr uint8_t kNotBuiltin = UINT8_MAX;
+
+// Perfect hash of the builtin names, with the seed searched for at compile time.
+static constexpr int kBuiltinSlotBits = 7;
+static constexpr size_t kBuiltinSlots = 1 << kBuiltinSlotBits;
+
+// FNV-1a, whose top bits depend on every char.
+static constexpr size_t BuiltinSlot(std::string_view name, uint32_t seed) {
+    uint32_t hash = seed;
+    for (char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash >> (32 - kBuiltinSlotBits);
+}
+
+static constexpr uint32_t FindBuiltinSeed() {
+    for (uint32_t i = 0;; ++i) {
+        // Consecutive seeds would share their top bits.
+        uint32_t seed = 2166136261u + i * 0x9e3779b9u;
+        bool taken[kBuiltinSlots] = {};
+        bool collision = false;
+        for (const auto& builtin : kBuiltins) {
+            auto slot = BuiltinSlot(builtin.name, seed);
+            collision = collision || taken[slot];
+            taken[slot] = true;
+        }
+        if (!collision) {
+            return seed;
+        }
+    }
+}
+
+static constexpr uint32_t kBuiltinSeed = FindBuiltinSeed();
+
+// Index + 1 of the builtin hashed to each slot, 0 for none.
+static constexpr auto kBuiltinTable = [] {
+    std::array<uint8_t, kBuiltinSlots> table{};
+    for (size_t i = 0; i < kBuiltinCount; ++i) {
+        table[BuiltinSlot(kBuiltins[i].name, kBuiltinSeed)] = i + 1;
+    }
+    return table;
+}();
+
+static_assert(kBuiltinCount < kNotBuiltin);
+
+static uint8_t ResolveBuiltin(const Symbol* symbol) {
+    // Interned once, so telling a builtin from a name that merely hashes to its slot is a
+    // pointer compare.
+    static const auto kInterned = [] {
+        std::array<const std::string*, kBuiltinCount> interned;
+        for (size_t i = 0; i < kBuiltinCount; ++i) {
+            interned[i] = Intern(kBuiltins[i].name);
+        }
+        return interned;
+    }();
+    auto builtin = kBuiltinTable[BuiltinSlot(symbol->GetName(), kBuiltinSeed)];
+    if (builtin == 0 || kInterned[builtin - 1] != symbol->GetInterned()) {
+        return kNotBuiltin;
+    }
+    return builtin;
 }
 
-std::shared_ptr<Object> Count(std::shared_ptr<Object> tree) {
+Function* FunctionCreator(const Symbol* symbol) {
+    auto builtin = symbol->GetBuiltin();
+    if (builtin == kUnresolved) {
+        builtin = ResolveBuiltin(symbol);
+        symbol->SetBuiltin(builtin);
+    }
+    if (builtin == kNotBuiltin) {
+        return nullptr;
+    }
+    return kBuiltins[builtin - 1].get();
+}
+
+Value Count(const Value& tree) {
     if (tree == nullptr) {
         throw RuntimeError("Invalid syntax");
     }
@@ -1108,45 +951,122 @@ std::shared_ptr<Object> Count(std::shared_ptr<Object> tree) {
     }
     auto pair = As<Cell>(tree);
     auto first_arg = RealCount(pair->GetFirst()).first;
-    if (first_arg == nullptr || !Is<Symbol>(first_arg) ||
-        FunctionCreator(As<Symbol>(first_arg)->GetName()) == nullptr) {
-        throw RuntimeError("Invalid operands, there should be a function first");
+    Function* func = nullptr;
+    if (Is<Symbol>(first_arg)) {
+        func = FunctionCreator(As<Symbol>(first_arg));
     }
-    auto symb = As<Symbol>(first_arg);
-    auto func = FunctionCreator(symb->GetName());
-    if (func->IsBoolean()) {
-        return func->Do(pair->GetSecond());
+    if (!func) {
+        throw RuntimeError("Invalid operands, there should be a function first");
     }
-    return func->Do(RealCount(pair->GetSecond(), func->IsQuote()).first);
+    return ApplyFunction(func, pair->GetSecond()).first;
 }
 
-std::pair<std::shared_ptr<Object>, bool> RealCount(std::shared_ptr<Object> tree, bool isquote) {
+std::pair<Value, bool> RealCount(const Value& tree, bool isquote) {
     if (tree == nullptr || !Is<Cell>(tree)) {
         return std::make_pair(tree, false);
     }
-    auto first = RealCount(As<Cell>(tree)->GetFirst());
-    if (first.first != nullptr && Is<Cell>(first.first) && !isquote && !first.second) {
-        throw RuntimeError("Invalid syntax");
+    // Evaluates the elements one after another until one of them names a function, which is
+    // applied to the rest. The evaluated elements are collected into one run of cells.
+    std::vector<Value> elements;
+    auto rest = tree;
+    while (true) {
+        auto pair = As<Cell>(rest);
+        auto first = RealCount(pair->GetFirst());
+        if (first.first != nullptr && Is<Cell>(first.first) && !first.second &&
+            (!isquote || !elements.empty())) {
+            throw RuntimeError("Invalid syntax");
+        }
+        Function* func = nullptr;
+        if (Is<Symbol>(first.first)) {
+            func = FunctionCreator(As<Symbol>(first.first));
+        }
+        if (func) {
+            auto result = ApplyFunction(func, pair->GetSecond());
+            if (elements.empty()) {
+                return result;
+            }
+            return std::make_pair(NewList(elements, std::move(result.first)), false);
+        }
+        elements.push_back(std::move(first.first));
+        rest = pair->GetSecond();
+        if (rest == nullptr || !Is<Cell>(rest)) {
+            return std::make_pair(NewList(elements, rest), false);
+        }
+    }
+}
+
+std::pair<Value, bool> ApplyFunction(Function* func, const Value& rest) {
+    if (func->IsBoolean()) {
+        return std::make_pair(func->Do(rest), false);
     }
-    auto pair = std::make_shared<Cell>(first.first, As<Cell>(tree)->GetSecond());
-    if (pair->GetFirst() != nullptr && Is<Symbol>(pair->GetFirst()) &&
-        FunctionCreator(As<Symbol>(pair->GetFirst())->GetName()) != nullptr) {
-        auto symb = As<Symbol>(pair->GetFirst());
-        auto func = FunctionCreator(symb->GetName());
-        if (func->IsBoolean()) {
-            return std::make_pair(func->Do(pair->GetSecond()), false);
+    return std::make_pair(func->Do(RealCount(rest, func->IsQuote()).first), func->IsQuote());
+}
+
+std::string Interpreter::Run(std::string_view string) {
+    if (collector_) {
+        std::string ans;
+        {
+            CollectorScope scope{collector_.get()};
+            ans = Evaluate(string);
         }
-        return std::make_pair(func->Do(RealCount(pair->GetSecond(), func->IsQuote()).first),
-                              func->IsQuote());
+        // Every temporary of the run is gone, which makes this a safe point.
+        collector_->Step();
+        return ans;
     }
-    return std::make_pair(
-        std::make_shared<Cell>(pair->GetFirst(), RealCount(pair->GetSecond()).first), false);
+    // Nothing from the previous request is alive any more, so its memory is reused wholesale.
+    arena_.Reset();
+    ArenaScope scope{&arena_};
+    return Evaluate(string);
 }
 
-std::string Interpreter::Run(const std::string& string) {
-    auto tree = ReadAll(string);
-    auto count = Count(tree);
+std::string Interpreter::Evaluate(std::string_view string) {
+    auto defined = environment_.GetDefinedCount();
+    auto count = GetProgram(string).Run(max_depth_);
+    if (environment_.GetDefinedCount() != defined) {
+        // They took the new name for a constant.
+        programs_.clear();
+    }
     std::string ans;
     OutputFirst(count, ans);
     return ans;
 }
+
+const Program& Interpreter::GetProgram(std::string_view string) {
+    if (auto it = programs_.find(string); it != programs_.end()) {
+        return it->second;
+    }
+    std::optional<Program> program;
+    {
+        // Programs outlive the run, so the tree and their constants are built on the heap.
+        ArenaScope heap{nullptr};
+        CollectorScope untracked{nullptr};
+        program.emplace(ReadAll(string), &environment_);
+    }
+    if (programs_.size() == kMaxPrograms) {
+        programs_.clear();
+    }
+    return programs_.emplace(string, std::move(*program)).first->second;
+}
+
+const Arena& Interpreter::GetArena() const {
+    return arena_;
+}
+
+void Interpreter::EnableCollector(std::chrono::nanoseconds step_budget) {
+    if (!collector_) {
+        collector_ = std::make_unique<Collector>(step_budget);
+        environment_.SetCollector(collector_.get());
+    }
+}
+
+const Collector* Interpreter::GetCollector() const {
+    return collector_.get();
+}
+
+void Interpreter::SetMaxDepth(size_t max_depth) {
+    max_depth_ = max_depth;
+}
+
+void Interpreter::SetReclaimer(Reclaimer* reclaimer) {
+    environment_.SetReclaimer(reclaimer);
+}
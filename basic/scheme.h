@@ -1,19 +1,45 @@
 #pragma once
 
 #include "parser.h"
+#include "collector.h"
+#include "numeric.h"
+#include "bytecode.h"
 
+#include <chrono>
+#include <memory>
+#include <span>
 #include <sstream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <limits>
 #include <algorithm>
 
-std::shared_ptr<Object> ReadAll(const std::string& str);
+Value ReadAll(std::string_view str);
 
-void OutputFirst(std::shared_ptr<Object> tree, std::string& ans);
+void OutputFirst(const Value& tree, std::string& ans);
 
-void OutputSecond(std::shared_ptr<Object> tree, std::string& ans);
+void OutputSecond(const Value& tree, std::string& ans);
 
-class Function;
+class Function {
+public:
+    virtual ~Function() = default;
+    virtual Value Do(const Value& ptr) = 0;
+    // The same as Do on a proper list of the arguments.
+    virtual Value Call(std::span<Value> args) {
+        return Do(NewList(args));
+    }
+    virtual bool IsBoolean() {
+        return false;
+    }
+    virtual bool IsQuote() {
+        return false;
+    }
+    // Call takes the arguments as they are, without a list built for them.
+    virtual bool IsArithmetic() {
+        return false;
+    }
+};
 
 class QuoteFunction;
 
@@ -43,6 +69,10 @@ class MinFunction;
 
 class AbsFunction;
 
+class ExptFunction;
+
+class ModularExptFunction;
+
 class IsBooleanFunction;
 
 class NotFunctioon;
@@ -69,14 +99,64 @@ class ListRefFunction;
 
 class ListTail;
 
-std::unique_ptr<Function> FunctionCreator(const std::string& func_string);
+class LengthFunction;
+
+// nullptr if the symbol doesn't name a builtin. The builtin is shared and never freed, the
+// answer is remembered by the symbol.
+Function* FunctionCreator(const Symbol* symbol);
 
-std::shared_ptr<Object> Count(std::shared_ptr<Object> tree);
+// The tree walker. Programs evaluate the same way and fall back to it for what and and or
+// can't have compiled, see bytecode.h.
+Value Count(const Value& tree);
 
-std::pair<std::shared_ptr<Object>, bool> RealCount(std::shared_ptr<Object> tree,
-                                                   bool isquote = false);
+std::pair<Value, bool> RealCount(const Value& tree, bool isquote = false);
+
+// Applies a builtin to the unevaluated rest of the list it heads, the flag is RealCount's.
+std::pair<Value, bool> ApplyFunction(Function* func, const Value& rest);
 
 class Interpreter {
 public:
-    std::string Run(const std::string& string);
+    std::string Run(std::string_view string);
+
+    const Arena& GetArena() const;
+
+    // From now on objects are built on the traced heap instead of the arena, and the collector
+    // gets one step after every run. Runs empty its nursery at calls once it is full. State kept
+    // between runs has to be registered as its root.
+    void EnableCollector(std::chrono::nanoseconds step_budget = Collector::kDefaultBudget);
+
+    // nullptr unless enabled.
+    const Collector* GetCollector() const;
+
+    // Runs throw RuntimeError once more calls than this wait for the ones they made to return.
+    void SetMaxDepth(size_t max_depth);
+
+    // Definitions that are defined over, or go with the interpreter, are freed on the thread of
+    // the reclaimer from now on. It has to outlive the interpreter.
+    void SetReclaimer(Reclaimer* reclaimer);
+
+private:
+    struct ProgramHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view string) const {
+            return std::hash<std::string_view>{}(string);
+        }
+    };
+
+    // Bounds the memory taken by programs of expressions that are never run again.
+    static constexpr size_t kMaxPrograms = 1024;
+
+    std::string Evaluate(std::string_view string);
+
+    // Compiled on the first run of the expression and kept for the next ones.
+    const Program& GetProgram(std::string_view string);
+
+    std::unordered_map<std::string, Program, ProgramHash, std::equal_to<>> programs_;
+    // Owns every object built by Run; the answer leaves it as a string.
+    Arena arena_;
+    std::unique_ptr<Collector> collector_;
+    // Goes before the collector it registered its roots with.
+    Environment environment_;
+    size_t max_depth_ = Program::kDefaultMaxDepth;
 };
@@ -0,0 +1,338 @@
+#include <slab.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+static constexpr size_t kGranule = 8;
+static constexpr size_t kClasses = kMaxSlabSize / kGranule;
+static constexpr size_t kChunkSize = 2 << 20;
+// What a thread takes from a chunk at a time for one class.
+static constexpr size_t kSpanSize = 64 << 10;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Counters are only written by the owning thread. They are atomic so that statistics can
+// read them meanwhile, plain loads and stores are enough for that.
+struct ClassCache {
+    FreeBlock* free = nullptr;
+    size_t free_count = 0;
+    // Blocks freed while the free list is full, handed to the shared list a span's worth at a
+    // time. A thread that frees what others allocate doesn't keep it all.
+    FreeBlock* batch = nullptr;
+    FreeBlock* batch_last = nullptr;
+    size_t batch_count = 0;
+    char* pos = nullptr;
+    char* end = nullptr;
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> frees{0};
+};
+
+// Spans of runs start with the bytes of the objects alive in them, plus one while a thread is
+// still carving runs out of the span.
+struct RunSpan {
+    std::atomic<size_t> live;
+};
+
+static constexpr size_t kRunHeader = alignof(std::max_align_t);
+
+struct ThreadCache {
+    ClassCache classes[kClasses];
+    RunSpan* run_span = nullptr;
+    char* run_pos = nullptr;
+    bool registered = false;
+    // Retired already, what the thread frees from now on goes straight to the shared lists.
+    bool exited = false;
+};
+
+struct SharedClass {
+    FreeBlock* free = nullptr;
+    size_t free_count = 0;
+    size_t reserved = 0;
+    // Counts of threads that have exited.
+    size_t allocations = 0;
+    size_t frees = 0;
+};
+
+struct Shared {
+    std::mutex mutex;
+    char* chunk_pos = nullptr;
+    char* chunk_end = nullptr;
+    SharedClass classes[kClasses];
+    std::vector<ThreadCache*> caches;
+    // Spans of runs with nothing alive in them.
+    std::vector<RunSpan*> run_spans;
+};
+
+// Never destroyed: blocks may be freed by threads that exit after static destructors ran.
+static Shared& GetShared() {
+    static auto shared = new Shared;
+    return *shared;
+}
+
+// Trivially destructible, so it stays usable for objects freed late in the thread's exit.
+static thread_local ThreadCache cache;
+
+static void Increment(std::atomic<size_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+static size_t ClassOf(size_t size) {
+    return (std::max<size_t>(size, 1) - 1) / kGranule;
+}
+
+// Free blocks a thread keeps for itself, and the size of the batches it gives away beyond that.
+static size_t LocalLimit(size_t index) {
+    return kSpanSize / ((index + 1) * kGranule);
+}
+
+static void PushShared(SharedClass* global, FreeBlock* first, FreeBlock* last, size_t count) {
+    last->next = global->free;
+    global->free = first;
+    global->free_count += count;
+}
+
+static char* NewChunk() {
+    auto chunk = static_cast<char*>(std::aligned_alloc(kChunkSize, kChunkSize));
+    if (!chunk) {
+        throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(chunk, kChunkSize, MADV_HUGEPAGE);
+#endif
+    return chunk;
+}
+
+// Needs the lock.
+static char* NewSpan(Shared* shared) {
+    if (shared->chunk_pos == shared->chunk_end) {
+        shared->chunk_pos = NewChunk();
+        shared->chunk_end = shared->chunk_pos + kChunkSize;
+    }
+    auto span = shared->chunk_pos;
+    shared->chunk_pos += kSpanSize;
+    return span;
+}
+
+// Takes bytes out of the count of the span, true when that leaves it free.
+static bool ReleaseRunBytes(RunSpan* span, size_t bytes) {
+    return span->live.fetch_sub(bytes, std::memory_order_acq_rel) == bytes;
+}
+
+// Leaves what the thread had to the others.
+static void Retire(ThreadCache* thread) {
+    auto& shared = GetShared();
+    std::lock_guard lock{shared.mutex};
+    if (thread->run_span && ReleaseRunBytes(thread->run_span, 1)) {
+        shared.run_spans.push_back(thread->run_span);
+    }
+    thread->run_span = nullptr;
+    thread->run_pos = nullptr;
+    for (size_t i = 0; i < kClasses; ++i) {
+        auto& local = thread->classes[i];
+        auto& global = shared.classes[i];
+        auto block_size = (i + 1) * kGranule;
+        for (; local.pos && local.pos + block_size <= local.end; local.pos += block_size) {
+            auto block = reinterpret_cast<FreeBlock*>(local.pos);
+            block->next = local.free;
+            local.free = block;
+        }
+        while (local.free) {
+            auto block = local.free;
+            local.free = block->next;
+            PushShared(&global, block, block, 1);
+        }
+        if (local.batch) {
+            PushShared(&global, local.batch, local.batch_last, local.batch_count);
+        }
+        local.free_count = local.batch_count = 0;
+        local.batch = local.batch_last = nullptr;
+        local.pos = local.end = nullptr;
+        global.allocations += local.allocations.load(std::memory_order_relaxed);
+        global.frees += local.frees.load(std::memory_order_relaxed);
+        local.allocations.store(0, std::memory_order_relaxed);
+        local.frees.store(0, std::memory_order_relaxed);
+    }
+    std::erase(shared.caches, thread);
+    thread->registered = false;
+    thread->exited = true;
+}
+
+struct CacheRetirer {
+    ~CacheRetirer() {
+        Retire(&cache);
+    }
+};
+
+static thread_local CacheRetirer retirer;
+
+// Makes the thread's counters visible to statistics. Needs the lock.
+static void Register(Shared* shared) {
+    // Constructing the retirer schedules Retire for the thread's exit.
+    static_cast<void>(&retirer);
+    shared->caches.push_back(&cache);
+    cache.registered = true;
+}
+
+// The free list is empty: takes the batch back, bumps through the span, or takes over the
+// blocks other threads freed, or a new span.
+static void* Refill(size_t index) {
+    auto& local = cache.classes[index];
+    auto block_size = (index + 1) * kGranule;
+    if (auto block = local.batch) {
+        local.free = block->next;
+        local.free_count = local.batch_count - 1;
+        local.batch = local.batch_last = nullptr;
+        local.batch_count = 0;
+        return block;
+    }
+    if (local.pos && local.pos + block_size <= local.end) {
+        auto block = local.pos;
+        local.pos += block_size;
+        return block;
+    }
+    auto& shared = GetShared();
+    std::lock_guard lock{shared.mutex};
+    if (!cache.registered && !cache.exited) {
+        Register(&shared);
+    }
+    auto& global = shared.classes[index];
+    if (global.free) {
+        auto block = global.free;
+        local.free = block->next;
+        local.free_count = global.free_count - 1;
+        global.free = nullptr;
+        global.free_count = 0;
+        return block;
+    }
+    local.pos = NewSpan(&shared);
+    local.end = local.pos + kSpanSize;
+    global.reserved += kSpanSize;
+    auto block = local.pos;
+    local.pos += block_size;
+    return block;
+}
+
+void* SlabAllocate(size_t size) {
+    if (size > kMaxSlabSize) {
+        return ::operator new(size);
+    }
+    auto index = ClassOf(size);
+    auto& local = cache.classes[index];
+    Increment(local.allocations);
+    if (auto block = local.free) {
+        local.free = block->next;
+        --local.free_count;
+        return block;
+    }
+    return Refill(index);
+}
+
+void SlabFree(void* block, size_t size) {
+    if (size > kMaxSlabSize) {
+        ::operator delete(block);
+        return;
+    }
+    auto index = ClassOf(size);
+    if (!cache.registered) {
+        auto& shared = GetShared();
+        std::lock_guard lock{shared.mutex};
+        if (cache.exited) {
+            auto free = static_cast<FreeBlock*>(block);
+            PushShared(&shared.classes[index], free, free, 1);
+            ++shared.classes[index].frees;
+            return;
+        }
+        Register(&shared);
+    }
+    auto& local = cache.classes[index];
+    Increment(local.frees);
+    auto free = static_cast<FreeBlock*>(block);
+    if (local.free_count < LocalLimit(index)) {
+        free->next = local.free;
+        local.free = free;
+        ++local.free_count;
+        return;
+    }
+    free->next = local.batch;
+    if (!local.batch) {
+        local.batch_last = free;
+    }
+    local.batch = free;
+    if (++local.batch_count == LocalLimit(index)) {
+        auto& shared = GetShared();
+        std::lock_guard lock{shared.mutex};
+        PushShared(&shared.classes[index], local.batch, local.batch_last, local.batch_count);
+        local.batch = local.batch_last = nullptr;
+        local.batch_count = 0;
+    }
+}
+
+static char* EndOf(RunSpan* span) {
+    return reinterpret_cast<char*>(span) + kSpanSize;
+}
+
+void* SlabAllocateRun(size_t size, size_t* count) {
+    if (!cache.run_span || cache.run_pos + size > EndOf(cache.run_span)) {
+        auto& shared = GetShared();
+        std::lock_guard lock{shared.mutex};
+        if (!cache.registered && !cache.exited) {
+            Register(&shared);
+        }
+        if (cache.run_span && ReleaseRunBytes(cache.run_span, 1)) {
+            shared.run_spans.push_back(cache.run_span);
+        }
+        if (shared.run_spans.empty()) {
+            cache.run_span = reinterpret_cast<RunSpan*>(NewSpan(&shared));
+        } else {
+            cache.run_span = shared.run_spans.back();
+            shared.run_spans.pop_back();
+        }
+        new (cache.run_span) RunSpan{1};
+        cache.run_pos = reinterpret_cast<char*>(cache.run_span) + kRunHeader;
+    }
+    *count = std::min<size_t>(*count, (EndOf(cache.run_span) - cache.run_pos) / size);
+    auto run = cache.run_pos;
+    cache.run_pos += *count * size;
+    cache.run_span->live.fetch_add(*count * size, std::memory_order_relaxed);
+    return run;
+}
+
+void SlabFreeInRun(void* object, size_t size) {
+    // Spans are aligned to their size.
+    auto span = reinterpret_cast<RunSpan*>(reinterpret_cast<uintptr_t>(object) & ~(kSpanSize - 1));
+    if (ReleaseRunBytes(span, size)) {
+        auto& shared = GetShared();
+        std::lock_guard lock{shared.mutex};
+        shared.run_spans.push_back(span);
+    }
+}
+
+std::vector<SlabStats> GetSlabStats() {
+    auto& shared = GetShared();
+    std::lock_guard lock{shared.mutex};
+    std::vector<SlabStats> stats(kClasses);
+    for (size_t i = 0; i < kClasses; ++i) {
+        size_t allocations = shared.classes[i].allocations;
+        size_t frees = shared.classes[i].frees;
+        for (auto thread : shared.caches) {
+            allocations += thread->classes[i].allocations.load(std::memory_order_relaxed);
+            frees += thread->classes[i].frees.load(std::memory_order_relaxed);
+        }
+        stats[i].block_size = (i + 1) * kGranule;
+        stats[i].reserved_bytes = shared.classes[i].reserved;
+        stats[i].allocations = allocations;
+        stats[i].live_blocks = allocations - frees;
+    }
+    return stats;
+}
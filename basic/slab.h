@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Pools of fixed-size blocks for objects on the heap, one per size class in steps of 8 bytes up
+// to kMaxSlabSize. Blocks of a class are carved out of 2 MiB chunks, which may be backed by
+// transparent huge pages and are never given back, so objects of one size sit close together.
+//
+// Every thread has free lists of its own, allocating and freeing take no lock. A block goes to
+// the lists of the thread that frees it, whichever thread allocated it; past a span's worth the
+// thread hands its frees to the others in batches, and the lists of a thread that exits are left
+// to the others. Bigger sizes go to operator new.
+static constexpr size_t kMaxSlabSize = 64;
+
+void* SlabAllocate(size_t size);
+
+// The size has to be the one the block was allocated with.
+void SlabFree(void* block, size_t size);
+
+// Runs of objects next to each other that are still freed one by one, like the cells of a
+// list. Runs are carved out of spans of their own, a span is reused once everything in it is
+// freed. So an object that lives long keeps the rest of its span, at most 64 KiB, around.
+//
+// Room for at least one and at most *count objects of the size, *count is set to how many
+// there is room for.
+void* SlabAllocateRun(size_t size, size_t* count);
+
+// An object of a run, with the size it was allocated with. May be called from any thread.
+void SlabFreeInRun(void* object, size_t size);
+
+struct SlabStats {
+    size_t block_size = 0;
+    // Chunk memory set aside for the class.
+    size_t reserved_bytes = 0;
+    size_t allocations = 0;
+    size_t live_blocks = 0;
+};
+
+// One entry per size class, totals over all threads.
+std::vector<SlabStats> GetSlabStats();
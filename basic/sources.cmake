@@ -1,6 +1,17 @@
 add_library(scheme_basic
+    bigint.cpp
+    symbol_table.cpp
     tokenizer.cpp
+    char_scan.cpp
+    arena.cpp
+    slab.cpp
+    object.cpp
+    numeric.cpp
+    collector.cpp
+    reclaimer.cpp
     parser.cpp
+    loader.cpp
+    bytecode.cpp
     scheme.cpp
     
     # maybe more .cpp files here
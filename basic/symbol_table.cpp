@@ -0,0 +1,83 @@
+#include <symbol_table.h>
+
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+// The hash of a name is computed once per lookup and stored with the name, so neither
+// picking a shard nor rehashing a shard hashes a string again.
+struct InternedName {
+    std::string name;
+    size_t hash;
+};
+
+struct NameKey {
+    std::string_view name;
+    size_t hash;
+};
+
+struct NameHash {
+    using is_transparent = void;
+
+    size_t operator()(const InternedName& x) const {
+        return x.hash;
+    }
+    size_t operator()(const NameKey& x) const {
+        return x.hash;
+    }
+};
+
+struct NameEqual {
+    using is_transparent = void;
+
+    template <class A, class B>
+    bool operator()(const A& a, const B& b) const {
+        return a.hash == b.hash && a.name == b.name;
+    }
+};
+
+// Files may be tokenized on several threads. The table is split into shards with their own
+// locks, and almost all lookups find an existing name under a shared lock.
+// Nodes of unordered_set never move, so pointers to the stored strings stay valid.
+struct SymbolTableShard {
+    std::shared_mutex mutex;
+    std::unordered_set<InternedName, NameHash, NameEqual> names;
+};
+
+static constexpr size_t kShards = 16;
+
+static std::array<SymbolTableShard, kShards>& GetShards() {
+    static std::array<SymbolTableShard, kShards> shards;
+    return shards;
+}
+
+static NameKey MakeKey(std::string_view name) {
+    return {name, std::hash<std::string_view>{}(name)};
+}
+
+static SymbolTableShard& GetShard(const NameKey& key) {
+    return GetShards()[key.hash % kShards];
+}
+
+const std::string* Intern(std::string_view name) {
+    auto key = MakeKey(name);
+    auto& shard = GetShard(key);
+    {
+        std::shared_lock lock{shard.mutex};
+        auto it = shard.names.find(key);
+        if (it != shard.names.end()) {
+            return &it->name;
+        }
+    }
+    std::unique_lock lock{shard.mutex};
+    return &shard.names.insert({std::string{name}, key.hash}).first->name;
+}
+
+const std::string* FindInterned(std::string_view name) {
+    auto key = MakeKey(name);
+    auto& shard = GetShard(key);
+    std::shared_lock lock{shard.mutex};
+    auto it = shard.names.find(key);
+    return it == shard.names.end() ? nullptr : &it->name;
+}
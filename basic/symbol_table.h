@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Process-wide table of symbol names. Every distinct name is stored once and never freed,
+// so interned names can be compared by pointer. Safe to use from several threads.
+const std::string* Intern(std::string_view name);
+
+// The interned name, or nullptr if nobody has interned it yet. Never grows the table.
+const std::string* FindInterned(std::string_view name);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <object.h>
+
+// The list (0 1 ... size - 1), built wherever New puts objects now.
+inline Value MakeList(int size) {
+    Value list;
+    for (int i = size - 1; i >= 0; --i) {
+        list = New<Cell>(Value::Integer(i), std::move(list));
+    }
+    return list;
+}
@@ -0,0 +1,63 @@
+#include <catch.hpp>
+
+#include <string>
+
+#include <bigint.h>
+
+static std::string Repeat(char digit, size_t count) {
+    return std::string(count, digit);
+}
+
+TEST_CASE("BigInt round trips through strings") {
+    for (std::string number : {"0", "1", "-1", "4294967295", "4294967296", "-18446744073709551616",
+                               "1000000000000000000000000000000"}) {
+        REQUIRE(BigInt::FromString(number).ToString() == number);
+    }
+    REQUIRE(BigInt::FromString("-0").ToString() == "0");
+    REQUIRE(BigInt(INT64_MIN).ToString() == "-9223372036854775808");
+    REQUIRE(BigInt(INT64_MIN).FitsInt64());
+    REQUIRE(BigInt(INT64_MIN).ToInt64() == INT64_MIN);
+    REQUIRE(!(BigInt(INT64_MAX) + 1).FitsInt64());
+    REQUIRE_THROWS(BigInt::FromString("12a"));
+}
+
+TEST_CASE("BigInt multiplication") {
+    // (10^n - 1)^2 = 10^2n - 2 * 10^n + 1, long enough for Karatsuba at the larger sizes.
+    for (size_t n : {5, 50, 500, 3000}) {
+        auto nines = BigInt::FromString(Repeat('9', n));
+        auto expected = Repeat('9', n - 1) + "8" + Repeat('0', n - 1) + "1";
+        REQUIRE((nines * nines).ToString() == expected);
+        REQUIRE((nines * -nines).ToString() == "-" + expected);
+    }
+    // Operands of very different lengths.
+    auto big = BigInt::FromString("1" + Repeat('0', 5000));
+    auto medium = BigInt::FromString(Repeat('7', 400));
+    REQUIRE((big * medium).ToString() == Repeat('7', 400) + Repeat('0', 5000));
+}
+
+TEST_CASE("BigInt division") {
+    auto a = BigInt::FromString("123456789012345678901234567890123456789012345678901234567890");
+    auto b = BigInt::FromString("-987654321098765432109876543210");
+    BigInt quotient;
+    BigInt remainder;
+    BigInt::DivMod(a, b, &quotient, &remainder);
+    REQUIRE(quotient.ToString() == "-124999998860937500014238281249");
+    REQUIRE(remainder.ToString() == "935329860093532986009353298600");
+    REQUIRE(quotient * b + remainder == a);
+
+    BigInt::DivMod(-a, BigInt(11), &quotient, &remainder);
+    REQUIRE(quotient * 11 + remainder == -a);
+    REQUIRE(remainder.ToString() == "-3");
+    REQUIRE(remainder.IsNegative());
+    REQUIRE_THROWS(BigInt::DivMod(a, BigInt(), &quotient, &remainder));
+}
+
+TEST_CASE("BigInt powers") {
+    REQUIRE(BigInt::Pow(2, 64).ToString() == "18446744073709551616");
+    REQUIRE(BigInt::Pow(-3, 3).ToString() == "-27");
+    REQUIRE(BigInt::ModPow(4, 13, 497).ToString() == "445");
+    REQUIRE(BigInt::ModPow(-4, 3, 5).ToString() == "1");
+    auto modulus = BigInt::Pow(2, 127) - 1;
+    // Fermat: a^(p-1) = 1 mod p for the Mersenne prime 2^127 - 1.
+    REQUIRE(BigInt::ModPow(3, modulus - 1, modulus).ToString() == "1");
+}
@@ -0,0 +1,214 @@
+#include <catch.hpp>
+
+#include <bytecode.h>
+#include <error.h>
+#include <scheme.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Without expt, whose results would grow beyond any time limit.
+static const std::vector<std::string> kNames = {
+    "quote", "number?", "=",     "<",     "+",     "-",   "*",   "/",    "max",
+    "min",   "abs",     "not",   "and",   "or",    "boolean?",   "pair?", "null?",
+    "list?", "cons",    "car",   "cdr",   "list",  "list-ref",   "list-tail",
+    "length", "x",      "y",
+};
+
+// Random expressions, well formed or not, with builtins and lists wherever the reader
+// allows them.
+class ExpressionGenerator {
+public:
+    explicit ExpressionGenerator(uint32_t seed) : random_(seed){};
+
+    std::string Next() {
+        return Expression(0);
+    }
+
+private:
+    std::string Atom() {
+        switch (Below(8)) {
+            case 0:
+                return "#t";
+            case 1:
+                return "#f";
+            case 2:
+                return "'()";
+            case 3:
+                return Below(2) ? "9223372036854775807" : "-4611686018427387905";
+            case 4:
+            case 5:
+                return kNames[Below(kNames.size())];
+            case 6:
+                return "'" + kNames[Below(kNames.size())];
+            default:
+                return std::to_string(static_cast<int>(Below(11)) - 5);
+        }
+    }
+
+    std::string Expression(int depth) {
+        auto kind = Below(10);
+        if (depth > 3 || kind < 3) {
+            return Atom();
+        }
+        std::string list = kind < 5 ? "'(" : "(";
+        if (kind >= 5 && kind < 9) {
+            list += kNames[Below(kNames.size())];
+        }
+        for (auto count = Below(5); count > 0; --count) {
+            list += ' ';
+            list += Expression(depth + 1);
+        }
+        if (Below(6) == 0) {
+            list += " . " + Expression(depth + 1);
+        }
+        return list + ")";
+    }
+
+    size_t Below(size_t bound) {
+        return std::uniform_int_distribution<size_t>(0, bound - 1)(random_);
+    }
+
+    std::mt19937 random_;
+};
+
+template <class F>
+static std::string Outcome(F evaluate) {
+    try {
+        std::string ans;
+        OutputFirst(evaluate(), ans);
+        return ans;
+    } catch (const RuntimeError& error) {
+        return std::string("RuntimeError: ") + error.what();
+    } catch (const SyntaxError& error) {
+        return std::string("SyntaxError: ") + error.what();
+    }
+}
+
+TEST_CASE("Programs evaluate like the tree walker") {
+    ExpressionGenerator generator{42};
+    Arena arena;
+    // Nothing is defined in it, in a lambda every symbol is looked up anyway.
+    Environment environment;
+    size_t failures = 0;
+    for (int i = 0; i < 30000; ++i) {
+        auto expression = generator.Next();
+        Value tree;
+        try {
+            tree = ReadAll(expression);
+        } catch (const SyntaxError&) {
+            continue;
+        }
+        Program programs[] = {
+            Program{tree},
+            Program{ReadAll("((lambda () " + expression + "))"), &environment},
+        };
+        std::string expected;
+        {
+            ArenaScope scope{&arena};
+            expected = Outcome([&] { return Count(tree); });
+        }
+        arena.Reset();
+        // Twice, so that nothing a run leaves behind changes the next one.
+        for (int run = 0; run < 4; ++run) {
+            std::string actual;
+            {
+                ArenaScope scope{&arena};
+                actual = Outcome([&] { return programs[run % 2].Run(); });
+            }
+            arena.Reset();
+            if (actual != expected) {
+                ++failures;
+                CAPTURE(expression, run, expected, actual);
+                CHECK(actual == expected);
+            }
+        }
+        if (failures > 10) {
+            break;
+        }
+    }
+    REQUIRE(failures == 0);
+}
+
+TEST_CASE("Programs decide at compile time") {
+    // A quoted list of constants is one constant.
+    Program quoted{ReadAll("'(1 2 3 4 5 6 7 8 9 10)")};
+    REQUIRE(quoted.GetCodeSize() == 3);
+
+    Program list{ReadAll("(list 1 (+ 2 3) '(4 5) (car '(6 7)))")};
+    for (int i = 0; i < 3; ++i) {
+        std::string ans;
+        OutputFirst(list.Run(), ans);
+        REQUIRE(ans == "(1 5 (4 5) 6)");
+    }
+    REQUIRE_THROWS_AS(Program{nullptr}.Run(), RuntimeError);
+    REQUIRE_THROWS_AS(Program{ReadAll("(x 1)")}.Run(), RuntimeError);
+}
+
+TEST_CASE("Arithmetic takes its arguments from the stack") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(+ 1 2 (* 3 4) (- 10 (/ 8 2)))") == "21");
+    REQUIRE(interpreter.Run("(< 1 (max 2 3) (min 5 4) (abs -6))") == "#t");
+    REQUIRE_THROWS_AS(interpreter.Run("(+ 1 (list 2))"), RuntimeError);
+    // A value naming a builtin is applied to the arguments after it.
+    REQUIRE(interpreter.Run("(+ 1 (cdr '(a . +)) 2 3)") == "6");
+    REQUIRE(interpreter.Run("(+ (cdr '(a . *)) 2 3)") == "6");
+    REQUIRE(interpreter.Run("(* 2 (cdr '(a . quote)) 3)") == "6");
+}
+
+TEST_CASE("Interpreter keeps programs between runs") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(+ 1 2 (* 3 4))") == "15");
+    REQUIRE(interpreter.Run("(+ 1 2 (* 3 4))") == "15");
+    REQUIRE_THROWS_AS(interpreter.Run("(car '())"), RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.Run("(car '())"), RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.Run("(car"), SyntaxError);
+    for (int i = 0; i < 5000; ++i) {
+        REQUIRE(interpreter.Run("(- " + std::to_string(i) + " 1)") == std::to_string(i - 1));
+    }
+}
+
+// Run explicitly with `test_scheme_basic [benchmark]`.
+TEST_CASE("Compiled evaluation throughput", "[.benchmark]") {
+    ExpressionGenerator generator{7};
+    std::vector<std::string> expressions;
+    while (expressions.size() < 1000) {
+        auto expression = generator.Next();
+        try {
+            ReadAll(expression);
+            expressions.push_back(std::move(expression));
+        } catch (const SyntaxError&) {
+        }
+    }
+
+    constexpr int kRounds = 100;
+    auto measure = [&](auto evaluate) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRounds; ++i) {
+            for (const auto& expression : expressions) {
+                try {
+                    evaluate(expression);
+                } catch (const RuntimeError&) {
+                } catch (const SyntaxError&) {
+                }
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() * 1e6 / (kRounds * expressions.size());
+    };
+
+    Arena arena;
+    auto walked = measure([&](const std::string& expression) {
+        arena.Reset();
+        ArenaScope scope{&arena};
+        std::string ans;
+        OutputFirst(Count(ReadAll(expression)), ans);
+    });
+    Interpreter interpreter;
+    auto compiled = measure([&](const std::string& expression) { interpreter.Run(expression); });
+    std::cout << "tree walker: " << walked << " us per expression, compiled: " << compiled
+              << " us per expression" << std::endl;
+}
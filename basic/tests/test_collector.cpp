@@ -0,0 +1,229 @@
+#include <catch.hpp>
+
+#include "object_test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <collector.h>
+#include <scheme.h>
+
+static bool IsIntact(const Value& list, int size) {
+    Value node = list;
+    for (int i = 0; i < size; ++i) {
+        if (!Is<Cell>(node) || As<Number>(As<Cell>(node)->GetFirst())->GetValue() != i) {
+            return false;
+        }
+        node = As<Cell>(node)->GetSecond();
+    }
+    return node == nullptr;
+}
+
+// Every node points back at the head.
+static Value MakeCycle(int size) {
+    auto head = MakeList(size);
+    auto node = As<Cell>(head);
+    while (node->GetSecond()) {
+        node->SetFirst(head);
+        node = As<Cell>(node->GetSecond());
+    }
+    node->SetSecond(head);
+    return head;
+}
+
+TEST_CASE("Minor collection promotes survivors") {
+    Collector collector;
+    CollectorScope scope{&collector};
+
+    Value root = MakeList(100);
+    collector.AddRoot(&root);
+    MakeCycle(50);
+    MakeCycle(1);
+    REQUIRE(collector.GetYoungBytes() > 0);
+    REQUIRE(collector.GetStats().objects == 0);
+
+    collector.Minor();
+    REQUIRE(collector.GetYoungBytes() == 0);
+    REQUIRE(collector.GetStats().objects == 100);
+    REQUIRE(collector.GetStats().promoted_objects == 100);
+    REQUIRE(collector.GetStats().broken_objects >= 2);
+    REQUIRE(IsIntact(root, 100));
+
+    // Only the remembered set knows the old cell holds a young list.
+    As<Cell>(root)->SetSecond(MakeList(10));
+    collector.Minor();
+    REQUIRE(collector.GetYoungBytes() == 0);
+    REQUIRE(IsIntact(As<Cell>(root)->GetSecond(), 10));
+    REQUIRE(collector.GetStats().promoted_objects == 110);
+}
+
+TEST_CASE("Collector frees old cycles") {
+    Collector collector;
+    CollectorScope scope{&collector};
+
+    Value root = MakeList(100);
+    Value cycles = New<Cell>(MakeCycle(50), MakeCycle(1));
+    collector.AddRoot(&root);
+    collector.AddRoot(&cycles);
+    collector.Minor();
+    REQUIRE(collector.GetStats().objects == 152);
+    cycles = nullptr;
+
+    collector.Collect();
+    REQUIRE(collector.GetStats().live_objects == 100);
+    REQUIRE(collector.GetStats().broken_objects >= 2);
+    REQUIRE(IsIntact(root, 100));
+    // Cells that died behind the sweep while their cycle was broken are freed by the next one.
+    collector.Collect();
+    REQUIRE(collector.GetStats().objects == 100);
+    REQUIRE(collector.GetStats().bytes == 100 * sizeof(Cell));
+
+    collector.RemoveRoot(&root);
+    root = nullptr;
+    collector.Collect();
+    REQUIRE(collector.GetStats().objects == 0);
+    REQUIRE(collector.GetStats().bytes == 0);
+}
+
+TEST_CASE("Steps start a cycle once enough was promoted") {
+    Collector collector{std::chrono::hours{1}};
+    CollectorScope scope{&collector};
+
+    Value root = MakeList(Collector::kCycleThreshold - 1);
+    collector.AddRoot(&root);
+    REQUIRE(!collector.Step());
+    REQUIRE(!collector.IsMarking());
+    REQUIRE(collector.GetStats().last_step_work == 0);
+
+    Value more = New<Cell>(nullptr, nullptr);
+    collector.AddRoot(&more);
+    REQUIRE(collector.Step());
+    REQUIRE(collector.GetStats().cycles == 1);
+    REQUIRE(collector.GetStats().live_objects == Collector::kCycleThreshold);
+
+    // Nothing new since.
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(!collector.Step());
+    }
+    REQUIRE(collector.GetStats().cycles == 1);
+    REQUIRE(collector.GetStats().steps == 12);
+}
+
+TEST_CASE("Incremental marking") {
+    constexpr int kSize = 1'000'000;
+    constexpr size_t kWork = 50'000;
+    // Steps are cut by work only, whatever the machine.
+    Collector collector{std::chrono::hours{1}, kWork};
+    CollectorScope scope{&collector};
+
+    // Roots are marked in order, so the holder is scanned first and the other cell last.
+    Value other = New<Cell>(MakeList(kSize), nullptr);
+    Value big = MakeList(kSize);
+    Value holder = New<Cell>(nullptr, nullptr);
+    Value late;
+    Value cycles;
+    for (int i = 0; i < 1000; ++i) {
+        cycles = New<Cell>(MakeCycle(10), std::move(cycles));
+    }
+    collector.AddRoot(&other);
+    collector.AddRoot(&big);
+    collector.AddRoot(&holder);
+    collector.AddRoot(&late);
+    collector.AddRoot(&cycles);
+    collector.Minor();
+    cycles = nullptr;
+
+    REQUIRE(!collector.Step());
+    REQUIRE(collector.IsMarking());
+    // Only the write barrier can tell that the list is still reachable.
+    As<Cell>(holder)->SetFirst(As<Cell>(other)->GetFirst());
+    As<Cell>(other)->SetFirst(nullptr);
+    late = MakeList(1000);
+    for (int i = 0; i < 1000; ++i) {
+        MakeCycle(10);
+    }
+
+    size_t steps = 1;
+    for (bool done = false; !done; ++steps) {
+        done = collector.Step();
+        REQUIRE(collector.GetStats().last_step_work <= kWork);
+    }
+    // Both lists are marked and swept.
+    REQUIRE(steps > 4 * kSize / kWork);
+    REQUIRE(collector.GetStats().max_step_work == kWork);
+
+    REQUIRE(IsIntact(As<Cell>(holder)->GetFirst(), kSize));
+    REQUIRE(IsIntact(big, kSize));
+    REQUIRE(IsIntact(late, 1000));
+    const auto& stats = collector.GetStats();
+    REQUIRE(stats.cycles == 1);
+    REQUIRE(stats.broken_objects >= 2000);
+
+    collector.Collect();
+    REQUIRE(stats.live_objects == 2 * kSize + 1002);
+    collector.Collect();
+    REQUIRE(stats.objects == 2 * kSize + 1002);
+}
+
+TEST_CASE("Interpreter with a collector") {
+    Interpreter interpreter;
+    interpreter.EnableCollector();
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(interpreter.Run("(list-tail '(1 2 3 4) 2)") == "(3 4)");
+    }
+    const auto& stats = interpreter.GetCollector()->GetStats();
+    REQUIRE(stats.minor_collections == 100);
+    REQUIRE(stats.promoted_objects == 0);
+    // Nothing was promoted, so no cycle is worth starting.
+    REQUIRE(stats.cycles == 0);
+    REQUIRE(!interpreter.GetCollector()->IsMarking());
+    REQUIRE(stats.objects == 0);
+    REQUIRE(interpreter.GetCollector()->GetYoungBytes() == 0);
+    REQUIRE(interpreter.GetArena().GetUsed() == 0);
+}
+
+TEST_CASE("Runs empty the nursery at calls") {
+    Interpreter interpreter;
+    interpreter.EnableCollector();
+    REQUIRE(interpreter.Run("(define (loop n) (or (= n 0) (let ((l (list n n n n))) "
+                            "(loop (- n 1)))))") == "loop");
+    REQUIRE(interpreter.Run("(loop 1000000)") == "#t");
+    // Without collections during the run the nursery would have taken over 100 MiB.
+    const auto& stats = interpreter.GetCollector()->GetStats();
+    REQUIRE(stats.minor_collections > 50);
+    REQUIRE(stats.max_young_bytes < 2 * Collector::kDefaultNurserySize);
+    REQUIRE(stats.objects < 100);
+
+    // Whatever waits in frames and markers survives them.
+    REQUIRE(interpreter.Run("(define (sum n) (or (and (= n 0) 0) (let ((l (list n n))) "
+                            "((lambda (a b c) (+ a b c)) (car l) (sum (- n 1)) (car l)))))") ==
+            "sum");
+    REQUIRE(interpreter.Run("(sum 20000)") == std::to_string(20000 * 20001));
+    REQUIRE(interpreter.GetCollector()->GetStats().max_young_bytes <
+            2 * Collector::kDefaultNurserySize);
+}
+
+// Run explicitly with `test_scheme_basic [benchmark]`.
+TEST_CASE("Collector pauses", "[.benchmark]") {
+    constexpr int kSize = 10'000'000;
+    Collector collector;
+    CollectorScope scope{&collector};
+    Value list = MakeList(kSize);
+    collector.AddRoot(&list);
+    collector.Minor();
+
+    // The minor collection above promoted the list in one go, only the steps count here.
+    size_t steps = 0;
+    std::chrono::nanoseconds max_pause{};
+    for (bool done = false; !done; ++steps) {
+        done = collector.Step();
+        max_pause = std::max(max_pause, collector.GetStats().last_pause);
+    }
+    REQUIRE(IsIntact(list, kSize));
+    using Ms = std::chrono::duration<double, std::milli>;
+    std::cout << "cycle over " << kSize << " objects: " << steps << " steps, max pause "
+              << Ms(max_pause).count() << " ms, max work " << collector.GetStats().max_step_work
+              << " objects" << std::endl;
+    collector.RemoveRoot(&list);
+}
@@ -11,3 +11,38 @@ TEST_CASE_METHOD(SchemeTest, "Be careful") {
     ExpectRuntimeError("('() ())");
     ExpectEq("'(())", "(())");
 }
+
+TEST_CASE("Warm interpreter reuses its arena") {
+    Interpreter interpreter;
+    std::string expression = "(list 1 2 3 (+ 4 5) (max 6 7) (list-ref '(1 2 3) 1))";
+    REQUIRE(interpreter.Run(expression) == "(1 2 3 9 7 2)");
+    auto used = interpreter.GetArena().GetUsed();
+    auto capacity = interpreter.GetArena().GetCapacity();
+    REQUIRE(used > 0);
+
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(interpreter.Run(expression) == "(1 2 3 9 7 2)");
+    }
+    REQUIRE(interpreter.GetArena().GetUsed() == used);
+    REQUIRE(interpreter.GetArena().GetCapacity() == capacity);
+}
+
+TEST_CASE("Builtins are shared and resolved once per symbol") {
+    Symbol plus{"+"};
+    Symbol other_plus{"+"};
+    REQUIRE(plus.GetBuiltin() == 0);
+    auto function = FunctionCreator(&plus);
+    REQUIRE(function != nullptr);
+    REQUIRE(plus.GetBuiltin() != 0);
+    REQUIRE(FunctionCreator(&plus) == function);
+    REQUIRE(FunctionCreator(&other_plus) == function);
+    Symbol minus{"-"};
+    REQUIRE(FunctionCreator(&minus) != function);
+
+    for (auto name : {"plus", "lis", "list-", "", "quote?"}) {
+        Symbol symbol{name};
+        REQUIRE(FunctionCreator(&symbol) == nullptr);
+        REQUIRE(symbol.GetBuiltin() != 0);
+        REQUIRE(FunctionCreator(&symbol) == nullptr);
+    }
+}
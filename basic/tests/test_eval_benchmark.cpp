@@ -0,0 +1,54 @@
+#include <catch.hpp>
+
+#include <scheme.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::string Numbers(int count) {
+    std::string numbers;
+    for (int i = 0; i < count; ++i) {
+        numbers += ' ';
+        numbers += std::to_string(i);
+    }
+    return numbers;
+}
+
+// Run explicitly with `test_scheme_basic [benchmark]`.
+TEST_CASE("Evaluation throughput", "[.benchmark]") {
+    auto numbers = Numbers(200);
+    std::vector<std::string> expressions = {
+        "(list" + numbers + ")",
+        "(list-ref '(" + numbers + ") 150)",
+        "(list-tail '(" + numbers + ") 190)",
+        "(list? '(" + numbers + "))",
+        "(+" + numbers + ")",
+        "(max" + numbers + ")",
+        "(and" + numbers + ")",
+        "(null? '(" + numbers + "))",
+        "(length '(" + numbers + "))",
+    };
+
+    for (bool collector : {false, true}) {
+        Interpreter interpreter;
+        if (collector) {
+            interpreter.EnableCollector();
+        }
+        for (const auto& expression : expressions) {
+            REQUIRE_NOTHROW(interpreter.Run(expression));
+        }
+        constexpr int kRounds = 20000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kRounds; ++i) {
+            for (const auto& expression : expressions) {
+                interpreter.Run(expression);
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << (collector ? "evaluation with a collector: " : "evaluation: ")
+                  << elapsed.count() * 1e6 / (kRounds * expressions.size()) << " us per expression"
+                  << std::endl;
+    }
+}
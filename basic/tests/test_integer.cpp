@@ -4,6 +4,10 @@ TEST_CASE_METHOD(SchemeTest, "IntegersAreSelfEvaluating") {
     ExpectEq("4", "4");
     ExpectEq("-14", "-14");
     ExpectEq("+14", "14");
+    ExpectEq("9223372036854775807", "9223372036854775807");
+    ExpectEq("-9223372036854775808", "-9223372036854775808");
+    ExpectEq("9223372036854775808", "9223372036854775808");
+    ExpectEq("-99999999999999999999999", "-99999999999999999999999");
 }
 
 TEST_CASE_METHOD(SchemeTest, "IntegerPredicate") {
@@ -112,3 +116,61 @@ TEST_CASE_METHOD(SchemeTest, "IntegerAbsEdgeCases") {
     ExpectRuntimeError("(abs #t)");
     ExpectRuntimeError("(abs 1 2)");
 }
+
+TEST_CASE_METHOD(SchemeTest, "IntegerOverflowPromotes") {
+    ExpectEq("(+ 9223372036854775807 1)", "9223372036854775808");
+    ExpectEq("(- -9223372036854775808 1)", "-9223372036854775809");
+    ExpectEq("(* 4294967296 4294967296)", "18446744073709551616");
+    ExpectEq("(/ -9223372036854775808 -1)", "9223372036854775808");
+    ExpectEq("(abs -9223372036854775808)", "9223372036854775808");
+    ExpectEq("(- (+ 9223372036854775807 1) 1)", "9223372036854775807");
+    ExpectEq("(* 99999999999 99999999999 99999999999)",
+             "999999999970000000000299999999999");
+    ExpectEq("(number? (* 9223372036854775807 2))", "#t");
+    ExpectEq("(< 9223372036854775807 (+ 9223372036854775807 1))", "#t");
+    ExpectEq("(= (* 4294967296 4294967296) (* 65536 65536 65536 65536))", "#t");
+    ExpectEq("(max 1 (* 4294967296 4294967296) -5)", "18446744073709551616");
+}
+
+TEST_CASE_METHOD(SchemeTest, "BignumLiterals") {
+    ExpectEq("(+ 18446744073709551616 1)", "18446744073709551617");
+    ExpectEq("(- 9223372036854775808 1)", "9223372036854775807");
+    ExpectEq("(= 18446744073709551616 (* 4294967296 4294967296))", "#t");
+    ExpectEq("(define z 99999999999999999999999)", "z");
+    ExpectEq("(* z 10)", "999999999999999999999990");
+    ExpectEq("'(1 -18446744073709551616)", "(1 -18446744073709551616)");
+    // What a bignum prints as reads back as the same number.
+    ExpectEq("(expt 3 100)", "515377520732011331036461129765621272702107522001");
+    ExpectEq("(= (expt 3 100) 515377520732011331036461129765621272702107522001)", "#t");
+}
+
+TEST_CASE_METHOD(SchemeTest, "IntegerExpt") {
+    ExpectEq("(expt 2 10)", "1024");
+    ExpectEq("(expt -3 3)", "-27");
+    ExpectEq("(expt 7 0)", "1");
+    ExpectEq("(expt 2 100)", "1267650600228229401496703205376");
+    ExpectEq("(/ (expt 10 40) (expt 10 38))", "100");
+    ExpectEq("(= (* (expt 3 300) (expt 5 300)) (expt 15 300))", "#t");
+
+    ExpectEq("(modular-expt 3 1000000 1000000007)", "64935414");
+    ExpectEq("(modular-expt -2 3 5)", "2");
+    ExpectEq("(modular-expt 2 (expt 10 30) (expt 10 25))", "22607743740081787109376");
+
+    ExpectRuntimeError("(expt 2 -1)");
+    ExpectRuntimeError("(expt 2)");
+    ExpectRuntimeError("(modular-expt 2 10 0)");
+    ExpectRuntimeError("(modular-expt 2 -1 7)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "IntegerLongArgumentLists") {
+    // An improper tail hands the whole list to the builtin, which walks it without recursing.
+    std::string ones;
+    for (int i = 0; i < 1000000; ++i) {
+        ones += " 1";
+    }
+    ExpectEq("(+" + ones + " . 1)", "1000001");
+    ExpectEq("(=" + ones + " . 1)", "#t");
+    ExpectEq("(max" + ones + " . 2)", "2");
+    ExpectRuntimeError("(/" + ones + " . 0)");
+    ExpectRuntimeError("(-" + ones + " . #t)");
+}
@@ -0,0 +1,214 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "Define") {
+    ExpectEq("(define x 5)", "x");
+    ExpectEq("x", "5");
+    ExpectEq("(+ x 1)", "6");
+    ExpectEq("(define x (+ x 1))", "x");
+    ExpectEq("x", "6");
+    ExpectEq("(define l '(1 2 3))", "l");
+    ExpectEq("(car l)", "1");
+    ExpectEq("(list-tail l 1)", "(2 3)");
+    // Nothing is defined by that name yet.
+    ExpectEq("y", "y");
+
+    ExpectSyntaxError("(define)");
+    ExpectSyntaxError("(define z)");
+    ExpectSyntaxError("(define z 1 2)");
+    ExpectSyntaxError("(define 1 2)");
+    ExpectSyntaxError("(define car 1)");
+    ExpectSyntaxError("(define lambda 1)");
+    ExpectSyntaxError("(list (define z 1))");
+    ExpectEq("z", "z");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Lambda") {
+    ExpectEq("((lambda (x y) (+ x y)) 1 2)", "3");
+    ExpectEq("((lambda () 1 2 3))", "3");
+    ExpectEq("(lambda (x) x)", "#<procedure>");
+    ExpectEq("(list 1 (lambda (x) x))", "(1 #<procedure>)");
+    // Parameters shadow builtins.
+    ExpectEq("((lambda (list) (+ list 1)) 2)", "3");
+
+    ExpectEq("(define (square x) (* x x))", "square");
+    ExpectEq("(square 7)", "49");
+    ExpectEq("(+ (square 2) (square 3))", "13");
+    ExpectRuntimeError("(square)");
+    ExpectRuntimeError("(square 1 2)");
+
+    ExpectSyntaxError("(lambda)");
+    ExpectSyntaxError("(lambda (x))");
+    ExpectSyntaxError("(lambda (x x) x)");
+    ExpectSyntaxError("(lambda (1) 1)");
+    ExpectSyntaxError("(lambda (x . y) x)");
+    ExpectSyntaxError("(define (f) (define g 1))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Closures") {
+    ExpectEq("(define (adder n) (lambda (m) (+ n m)))", "adder");
+    ExpectEq("(define add5 (adder 5))", "add5");
+    ExpectEq("(add5 10)", "15");
+    ExpectEq("((adder 1) 2)", "3");
+    ExpectEq("(add5 1)", "6");
+
+    // Through lambdas that don't use the variable themselves.
+    ExpectEq("(define (curry a) (lambda (b) (lambda (c) (- a b c))))", "curry");
+    ExpectEq("(((curry 10) 2) 3)", "5");
+
+    // Passed as arguments, and applied where they head a list.
+    ExpectEq("(define (twice f x) (f (f x)))", "twice");
+    ExpectEq("(twice add5 1)", "11");
+    ExpectEq("(twice (adder 2) 1)", "5");
+    ExpectEq("(define (compose f g) (lambda (x) (f (g x))))", "compose");
+    ExpectEq("((compose add5 (adder 2)) 0)", "7");
+
+    // Globals are looked up when the code runs, not when the closure is made.
+    ExpectEq("(define (get) value)", "get");
+    ExpectEq("(get)", "value");
+    ExpectEq("(define value 1)", "value");
+    ExpectEq("(get)", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Let") {
+    ExpectEq("(let ((x 1) (y 2)) (+ x y))", "3");
+    ExpectEq("(let ((x 1)) (let ((x (+ x 1)) (y x)) (+ (* x 10) y)))", "21");
+    ExpectEq("(let () 1)", "1");
+    ExpectEq("(define (f x) (let ((y (* x 2))) (lambda () (+ x y))))", "f");
+    ExpectEq("((f 3))", "9");
+
+    ExpectSyntaxError("(let)");
+    ExpectSyntaxError("(let ((x 1)))");
+    ExpectSyntaxError("(let ((x 1) (x 2)) x)");
+    ExpectSyntaxError("(let ((x)) x)");
+    ExpectSyntaxError("(let (x) x)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Recursion") {
+    ExpectEq("(define (fact n) (or (and (< n 2) 1) (* n (fact (- n 1)))))", "fact");
+    ExpectEq("(fact 10)", "3628800");
+    ExpectEq("(fact 25)", "15511210043330985984000000");
+    ExpectEq("(define (fib n) (or (and (< n 2) n) (+ (fib (- n 1)) (fib (- n 2)))))", "fib");
+    ExpectEq("(fib 20)", "6765");
+    // A list made by an expression can't be an argument, a variable can hold it.
+    ExpectEq("(define (sum l) (or (and (null? l) 0) (let ((r (cdr l))) (+ (car l) (sum r)))))",
+             "sum");
+    ExpectEq("(sum '(1 2 3 4))", "10");
+}
+
+TEST_CASE("Definitions outlive the run that made them") {
+    for (bool collected : {false, true}) {
+        Interpreter interpreter;
+        if (collected) {
+            interpreter.EnableCollector();
+        }
+        REQUIRE(interpreter.Run("(define l (list 1 2 3))") == "l");
+        REQUIRE(interpreter.Run("(define (make n) (let ((m (list n n))) (lambda () m)))") ==
+                "make");
+        REQUIRE(interpreter.Run("(define pair (make 7))") == "pair");
+        for (int i = 0; i < 2000; ++i) {
+            REQUIRE(interpreter.Run("(list 4 5 6 (+ 7 8))") == "(4 5 6 15)");
+        }
+        REQUIRE(interpreter.Run("l") == "(1 2 3)");
+        REQUIRE(interpreter.Run("(pair)") == "(7 7)");
+        if (collected) {
+            REQUIRE(interpreter.GetCollector()->GetStats().promoted_objects > 0);
+        }
+    }
+}
+
+TEST_CASE_METHOD(SchemeTest, "Tail calls") {
+    ExpectEq("(define (loop n) (or (= n 0) (loop (- n 1))))", "loop");
+    ExpectEq("(loop 1000000)", "#t");
+    ExpectEq(
+        "(define (count n acc) (or (and (= n 0) acc) (let ((m (- n 1))) (count m (+ acc 1)))))",
+        "count");
+    ExpectEq("(count 1000000 0)", "1000000");
+    ExpectEq("(define (even n) (or (= n 0) (odd (- n 1))))", "even");
+    ExpectEq("(define (odd n) (and (not (= n 0)) (even (- n 1))))", "odd");
+    ExpectEq("(even 1000001)", "#f");
+
+    // And and or still check what the call in tail position returns.
+    ExpectEq("(define (empty n) (or (and (= n 0) '()) (empty (- n 1))))", "empty");
+    ExpectRuntimeError("(empty 3)");
+    ExpectEq("(define (quoted n) (or (and (= n 0) '(1)) (quoted (- n 1))))", "quoted");
+    ExpectRuntimeError("(quoted 3)");
+}
+
+TEST_CASE("Tail calls run in constant space") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(define (loop n) (or (= n 0) (loop (- n 1))))") == "loop");
+    // No frame is left waiting, and nothing is allocated.
+    interpreter.SetMaxDepth(10);
+    REQUIRE(interpreter.Run("(loop 1000000)") == "#t");
+    REQUIRE(interpreter.GetArena().GetUsed() == 0);
+
+    // What the iterations allocate stays in the arena until the run is over.
+    REQUIRE(interpreter.Run("(define (lists n) (or (= n 0) (let ((l (list n n n n))) "
+                            "(lists (- n 1)))))") == "lists");
+    REQUIRE(interpreter.Run("(lists 100000)") == "#t");
+    REQUIRE(interpreter.GetArena().GetUsed() >= 100000 * 4 * sizeof(Cell));
+    // A collector takes it back at the calls.
+    interpreter.EnableCollector();
+    REQUIRE(interpreter.Run("(lists 1000000)") == "#t");
+    const auto& stats = interpreter.GetCollector()->GetStats();
+    REQUIRE(stats.max_young_bytes < 2 * Collector::kDefaultNurserySize);
+    REQUIRE(stats.objects < 100);
+}
+
+TEST_CASE("Deep chains of closures are freed without recursing") {
+    for (bool collected : {false, true}) {
+        Interpreter interpreter;
+        if (collected) {
+            interpreter.EnableCollector();
+        }
+        REQUIRE(interpreter.Run("(define (chain n acc) (or (and (= n 0) acc) "
+                                "(chain (- n 1) (lambda () acc))))") == "chain");
+        REQUIRE(interpreter.Run("(chain 1000000 1)") == "#<procedure>");
+        REQUIRE(interpreter.Run("(((chain 2 1)))") == "1");
+
+        // Definitions are copied out of the arena just as deep.
+        REQUIRE(interpreter.Run("(define c (chain 1000000 1))") == "c");
+        REQUIRE(interpreter.Run("(define e (chain 2 1))") == "e");
+        REQUIRE(interpreter.Run("((e))") == "1");
+        // Closures holding lists ending in closures.
+        REQUIRE(interpreter.Run("(define (nest n acc) (or (and (= n 0) acc) "
+                                "(nest (- n 1) (lambda () (cons n acc)))))") == "nest");
+        REQUIRE(interpreter.Run("(define d (nest 1000000 1))") == "d");
+        REQUIRE(interpreter.Run("(define f (nest 1 2))") == "f");
+        REQUIRE(interpreter.Run("(f)") == "(1 . 2)");
+    }
+}
+
+TEST_CASE("Recursion is limited by the depth, not the C++ stack") {
+    Interpreter interpreter;
+    REQUIRE(interpreter.Run("(define (deep n) (or (and (= n 0) 0) (+ 1 (deep (- n 1)))))") ==
+            "deep");
+    REQUIRE(interpreter.Run("(deep 50000)") == "50000");
+    interpreter.SetMaxDepth(1000);
+    REQUIRE(interpreter.Run("(deep 1000)") == "1000");
+    REQUIRE_THROWS_AS(interpreter.Run("(deep 1001)"), RuntimeError);
+    REQUIRE(interpreter.Run("(deep 10)") == "10");
+    interpreter.SetMaxDepth(Program::kDefaultMaxDepth);
+
+    // Deep results are printed and defined without recursing either. And and or can't give a
+    // list, wrap picks the next step out of a list of procedures instead.
+    REQUIRE(interpreter.Run("(define (wrap n acc) (let ((next (list (lambda () acc) (lambda () "
+                            "(let ((l (list acc))) (wrap (- n 1) l)))))) "
+                            "((list-ref next (or (and (= n 0) 0) 1)))))") == "wrap");
+    REQUIRE(interpreter.Run("(define deep-list (wrap 200000 '(1)))") == "deep-list");
+    REQUIRE(interpreter.Run("deep-list") ==
+            std::string(200001, '(') + "1" + std::string(200001, ')'));
+
+    // Programs themselves may only be nested so deep.
+    auto nested = [](size_t depth) {
+        return std::string(depth, '(') + "1" + std::string(depth, ')');
+    };
+    REQUIRE_THROWS_WITH(interpreter.Run("'" + nested(Program::kMaxNesting)),
+                        "Nesting is too deep");
+    REQUIRE_THROWS_AS(interpreter.Run("'" + nested(Program::kMaxNesting - 1)), RuntimeError);
+    std::string sum = "0";
+    for (size_t i = 0; i < Program::kMaxNesting / 2; ++i) {
+        sum = "(+ 1 " + sum + ")";
+    }
+    REQUIRE(interpreter.Run(sum) == std::to_string(Program::kMaxNesting / 2));
+}
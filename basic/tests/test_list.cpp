@@ -77,3 +77,103 @@ TEST_CASE_METHOD(SchemeTest, "ListOperations") {
     ExpectRuntimeError("(list-ref '(1 2 3) 10)");
     ExpectRuntimeError("(list-tail '(1 2 3) 10)");
 }
+
+TEST_CASE_METHOD(SchemeTest, "ListLength") {
+    ExpectEq("(length '())", "0");
+    ExpectEq("(length '(1 2 3))", "3");
+    ExpectEq("(length '(1 #t 4 5))", "4");
+
+    ExpectRuntimeError("(length '(1 2 . 3))");
+    ExpectRuntimeError("(length 1)");
+    ExpectRuntimeError("(length '(1) '(2))");
+}
+
+static std::string Numbers(int count) {
+    std::string numbers;
+    for (int i = 0; i < count; ++i) {
+        numbers += ' ';
+        numbers += std::to_string(i);
+    }
+    return numbers;
+}
+
+TEST_CASE_METHOD(SchemeTest, "LongLists") {
+    auto list = "'(" + Numbers(200000) + ")";
+    ExpectEq("(list-ref " + list + " 199999)", "199999");
+    ExpectEq("(list-ref " + list + " 65536)", "65536");
+    ExpectEq("(list-tail " + list + " 199998)", "(199998 199999)");
+    ExpectEq("(length " + list + ")", "200000");
+    ExpectEq("(list? " + list + ")", "#t");
+    ExpectRuntimeError("(list-ref " + list + " 200000)");
+    ExpectEq("(length (quote (" + Numbers(70000) + " . ())))", "70000");
+}
+
+static Value ReadList(int count) {
+    return ReadAll("(" + Numbers(count) + ")");
+}
+
+TEST_CASE("Lists are built in runs of cells") {
+    Arena arena;
+    ArenaScope scope{&arena};
+    auto list = ReadList(100000);
+    auto head = As<Cell>(list);
+    REQUIRE(head->GetRun() == 100000 - 65536 - 1);
+    REQUIRE(head->Advance(99999)->GetFirst().GetFixnum() == 99999);
+    REQUIRE(head->Advance(100000) == nullptr);
+
+    // Changing a second slot cuts the runs that reached past it.
+    auto middle = head->Advance(10);
+    middle->SetSecond(ReadList(3));
+    REQUIRE(head->GetRun() == 10);
+    REQUIRE(head->Advance(5)->GetRun() == 5);
+    REQUIRE(middle->GetRun() == 0);
+    REQUIRE(head->Advance(12)->GetFirst().GetFixnum() == 1);
+    REQUIRE(head->Advance(14) == nullptr);
+    REQUIRE(As<Cell>(list)->Advance(11)->GetFirst().GetFixnum() == 0);
+}
+
+// Jumps from run to run through the list.
+static size_t CountRuns(Cell* cell) {
+    size_t runs = 0;
+    for (; cell; cell = cell->Advance(cell->GetRun() + 1)) {
+        ++runs;
+    }
+    return runs;
+}
+
+TEST_CASE("Lists outside an arena") {
+    std::vector<Value> elements = {Value::Integer(1), Value::Integer(2), Value::Integer(3)};
+    auto list = NewList(elements, Value::Integer(4));
+    REQUIRE(As<Cell>(list)->GetRun() == 2);
+    REQUIRE(As<Cell>(list)->Advance(2)->GetSecond().GetFixnum() == 4);
+
+    // Quoted lists of programs are read on the heap, in runs as long as a span has room for.
+    auto heap = ReadList(100000);
+    auto head = As<Cell>(heap);
+    REQUIRE(CountRuns(head) <= 100000 / 2000 + 1);
+    REQUIRE(head->Advance(99999)->GetFirst().GetFixnum() == 99999);
+    head->Advance(10)->SetSecond(nullptr);
+    REQUIRE(head->GetRun() == 10);
+    heap = nullptr;
+
+    // Definitions are copied out of the arena in runs as well.
+    Environment environment;
+    auto slot = environment.GetSlot(Intern("defined"));
+    {
+        Arena arena;
+        ArenaScope scope{&arena};
+        environment.Define(slot, ReadList(1000));
+    }
+    // The span it starts in may not have room for all of it.
+    REQUIRE(CountRuns(As<Cell>(*environment.Find(slot))) <= 2);
+
+    Collector collector;
+    CollectorScope scope{&collector};
+    Value young = ReadList(1000);
+    REQUIRE(As<Cell>(young)->GetRun() == 999);
+    collector.AddRoot(&young);
+    collector.Minor();
+    REQUIRE(As<Cell>(young)->GetRun() == 0);
+    REQUIRE(As<Cell>(young)->Advance(999)->GetFirst().GetFixnum() == 999);
+    collector.RemoveRoot(&young);
+}
@@ -0,0 +1,149 @@
+#include <catch.hpp>
+
+#include <arena.h>
+#include <error.h>
+#include <loader.h>
+#include <scheme.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+#include <unistd.h>
+
+class TempFile {
+public:
+    explicit TempFile(const std::string& contents) {
+        char path[] = "/tmp/scheme_loader_XXXXXX";
+        close(mkstemp(path));
+        path_ = path;
+        std::ofstream{path_} << contents;
+    }
+
+    ~TempFile() {
+        std::remove(path_.c_str());
+    }
+
+    const std::string& GetPath() const {
+        return path_;
+    }
+
+private:
+    std::string path_;
+};
+
+TEST_CASE("Load file") {
+    SECTION("Several data") {
+        TempFile file{"(1 2 . 3)\n foo\n'(bar) 42"};
+        auto result = LoadFile(file.GetPath());
+
+        REQUIRE(result.data.size() == 4);
+        REQUIRE(result.stats.data == 4);
+        REQUIRE(result.stats.bytes == 24);
+        REQUIRE(Is<Cell>(result.data[0]));
+        REQUIRE(As<Symbol>(result.data[1])->GetName() == "foo");
+        REQUIRE(Is<Cell>(result.data[2]));
+        REQUIRE(As<Number>(result.data[3])->GetValue() == 42);
+    }
+
+    SECTION("Empty file") {
+        TempFile file{""};
+        REQUIRE(LoadFile(file.GetPath()).data.empty());
+    }
+
+    SECTION("Errors") {
+        TempFile unclosed{"(1 2"};
+        REQUIRE_THROWS_AS(LoadFile(unclosed.GetPath()), SyntaxError);
+
+        TempFile stray{"1 2)"};
+        REQUIRE_THROWS_AS(LoadFile(stray.GetPath()), SyntaxError);
+
+        REQUIRE_THROWS_AS(LoadFile("/nonexistent/file.scm"), std::system_error);
+    }
+}
+
+TEST_CASE("Parallel load keeps data in order") {
+    std::string contents;
+    for (int i = 0; contents.size() < 3 * kMinParallelLoad; ++i) {
+        contents += "(define (f" + std::to_string(i) + " x)\n  (list-ref '(1 2 (3 4)) x))\n";
+        contents += "'   sym" + std::to_string(i) + "  " + std::to_string(i) + "\n'\n(a . b)\n";
+    }
+    TempFile file{contents};
+
+    auto sequential = LoadFile(file.GetPath(), 1);
+    auto parallel = LoadFile(file.GetPath(), 4);
+    REQUIRE(parallel.stats.threads == 4);
+    REQUIRE(sequential.stats.threads == 1);
+    std::string expected, actual;
+    for (const auto& datum : sequential.data) {
+        OutputFirst(datum, expected);
+        expected += '\n';
+    }
+    for (const auto& datum : parallel.data) {
+        OutputFirst(datum, actual);
+        actual += '\n';
+    }
+    REQUIRE(actual == expected);
+
+    TempFile broken{contents + "(1 2"};
+    REQUIRE_THROWS_AS(LoadFile(broken.GetPath(), 4), SyntaxError);
+}
+
+TEST_CASE("Parallel load splits around a long datum") {
+    std::string contents = "(";
+    size_t length = 0;
+    for (; contents.size() < 3 * kMinParallelLoad / 2; ++length) {
+        contents += "x ";
+    }
+    contents += ")\n";
+    int small = 0;
+    for (; contents.size() < 4 * kMinParallelLoad; ++small) {
+        contents += "(a " + std::to_string(small) + ")\n";
+    }
+    TempFile file{contents};
+
+    auto result = LoadFile(file.GetPath(), 4);
+    REQUIRE(result.stats.pieces > 8);
+    REQUIRE(result.data.size() == static_cast<size_t>(small) + 1);
+    size_t read = 0;
+    for (Value rest = result.data[0]; rest; rest = As<Cell>(rest)->GetSecond()) {
+        ++read;
+    }
+    REQUIRE(read == length);
+    std::string last;
+    OutputFirst(result.data.back(), last);
+    REQUIRE(last == "(a " + std::to_string(small - 1) + ")");
+}
+
+TEST_CASE("Loaded data are built on the heap") {
+    TempFile file{"(1 2 . 3)\n foo\n'(bar) 42"};
+    Arena arena;
+    ArenaScope scope{&arena};
+    REQUIRE(LoadFile(file.GetPath()).data.size() == 4);
+    REQUIRE(arena.GetUsed() == 0);
+
+    std::string contents;
+    while (contents.size() < 2 * kMinParallelLoad) {
+        contents += "(1 2 . 3)\n";
+    }
+    TempFile large{contents};
+    REQUIRE(LoadFile(large.GetPath(), 4).stats.pieces > 1);
+    REQUIRE(arena.GetUsed() == 0);
+}
+
+// Run explicitly with `test_scheme_basic [benchmark]`.
+TEST_CASE("Load throughput", "[.benchmark]") {
+    std::string contents;
+    for (int i = 0; contents.size() < (64 << 20); ++i) {
+        contents += "(entry " + std::to_string(i) + " (name item-" + std::to_string(i) +
+                    ") (values 1 2 3 4 5 6 7 8) '(nested (list (of things))))\n";
+    }
+    TempFile file{contents};
+
+    for (size_t threads = 1; threads <= std::thread::hardware_concurrency(); threads *= 2) {
+        auto stats = LoadFile(file.GetPath(), threads).stats;
+        std::cout << threads << " threads: " << stats.data << " data, "
+                  << stats.BytesPerSecond() / (1 << 20) << " MB/s" << std::endl;
+    }
+}
@@ -24,6 +24,50 @@ TEST_CASE("Read number") {
     REQUIRE(As<Number>(node)->GetValue() == -5);
 }
 
+TEST_CASE("Immediate values") {
+    auto node = ReadFull("4611686018427387903");
+    REQUIRE(node.IsFixnum());
+    REQUIRE(As<Number>(node)->GetValue() == 4611686018427387903);
+
+    node = ReadFull("-4611686018427387904");
+    REQUIRE(node.IsFixnum());
+    REQUIRE(As<Number>(node)->GetValue() == -4611686018427387904);
+
+    node = ReadFull("4611686018427387904");
+    REQUIRE(node.IsObject());
+    REQUIRE(Is<Number>(node));
+    REQUIRE(As<Number>(node)->GetValue() == 4611686018427387904);
+
+    node = ReadFull("#t");
+    REQUIRE(node.IsBoolean());
+    REQUIRE(node == Value::Boolean(true));
+    REQUIRE(!Is<Symbol>(node));
+
+    node = ReadFull("#f");
+    REQUIRE(node.IsFalse());
+    REQUIRE(node);
+
+    node = ReadFull("()");
+    REQUIRE(node == nullptr);
+    REQUIRE(!node.IsObject());
+}
+
+TEST_CASE("Read bignum") {
+    auto node = ReadFull("-9223372036854775809");
+    REQUIRE(Is<BigNumber>(node));
+    REQUIRE(As<BigNumber>(node)->GetValue().ToString() == "-9223372036854775809");
+
+    node = ReadFull("(1 +340282366920938463463374607431768211456)");
+    auto second = As<Cell>(As<Cell>(node)->GetSecond())->GetFirst();
+    REQUIRE(Is<BigNumber>(second));
+    REQUIRE(As<BigNumber>(second)->GetValue() == BigInt::Pow(2, 128));
+
+    // Only what doesn't fit into 64 bits.
+    node = ReadFull("-9223372036854775808");
+    REQUIRE(Is<Number>(node));
+    REQUIRE(As<Number>(node)->GetValue() == INT64_MIN);
+}
+
 std::string RandomSymbol(std::default_random_engine* rng) {
     std::uniform_int_distribution<int> symbol('a', 'z');
     std::string s;
@@ -154,3 +198,87 @@ TEST_CASE("Invalid") {
     REQUIRE_THROWS_AS(ReadFull("(1 . )"), SyntaxError);
     REQUIRE_THROWS_AS(ReadFull("(1 . 2 3)"), SyntaxError);
 }
+
+TEST_CASE("Long lists") {
+    SECTION("Ten million elements") {
+        constexpr int kLength = 10'000'000;
+        std::string input = "(";
+        for (int i = 0; i < kLength; ++i) {
+            input += "7 ";
+        }
+        input += ". 8)";
+
+        auto list = ReadFull(input);
+        int length = 0;
+        while (Is<Cell>(list)) {
+            ++length;
+            list = As<Cell>(list)->GetSecond();
+        }
+        REQUIRE(length == kLength);
+        REQUIRE(As<Number>(list)->GetValue() == 8);
+    }
+
+    SECTION("Deep nesting") {
+        constexpr int kDepth = 1'000'000;
+        auto list = ReadFull(std::string(kDepth, '(') + std::string(kDepth, ')'));
+        REQUIRE(Is<Cell>(list));
+        // Tear the nest down from the outside, one level per iteration.
+        while (list != nullptr) {
+            list = As<Cell>(list)->GetFirst();
+        }
+    }
+}
+
+TEST_CASE("Incremental reader") {
+    SECTION("Datum is ready as soon as it is closed") {
+        IncrementalReader reader;
+        std::string input = "(+ 1 (- 2 3))";
+        for (size_t i = 0; i + 1 < input.size(); ++i) {
+            reader.Feed(input.substr(i, 1));
+            REQUIRE(!reader.HasDatum());
+        }
+        REQUIRE(reader.Depth() == 1);
+
+        reader.Feed(")");
+        REQUIRE(reader.Depth() == 0);
+        REQUIRE(reader.HasDatum());
+        auto list = reader.TakeDatum();
+        REQUIRE(Is<Cell>(list));
+        REQUIRE(As<Symbol>(As<Cell>(list)->GetFirst())->GetName() == "+");
+        REQUIRE(!reader.HasDatum());
+    }
+
+    SECTION("Atoms split between chunks") {
+        IncrementalReader reader;
+        reader.Feed("12");
+        reader.Feed("34 foo");
+        REQUIRE(reader.HasDatum());
+        REQUIRE(As<Number>(reader.TakeDatum())->GetValue() == 1234);
+        REQUIRE(!reader.HasDatum());
+
+        reader.Feed("-bar '(1 ");
+        reader.Feed(". 2)");
+        REQUIRE(As<Symbol>(reader.TakeDatum())->GetName() == "foo-bar");
+        auto quote = reader.TakeDatum();
+        REQUIRE(As<Symbol>(As<Cell>(quote)->GetFirst())->GetName() == "quote");
+
+        reader.Feed("#t");
+        REQUIRE(!reader.HasDatum());
+        reader.Finish();
+        REQUIRE(reader.HasDatum());
+        reader.TakeDatum();
+    }
+
+    SECTION("Errors") {
+        IncrementalReader reader;
+        REQUIRE_THROWS_AS(reader.Feed("(1 . 2 3) 4 "), SyntaxError);
+        REQUIRE(As<Number>(reader.TakeDatum())->GetValue() == 4);
+
+        REQUIRE_THROWS_AS(reader.Feed(") 5 "), SyntaxError);
+        REQUIRE(As<Number>(reader.TakeDatum())->GetValue() == 5);
+
+        reader.Feed("'(1 2");
+        REQUIRE_THROWS_AS(reader.Finish(), SyntaxError);
+        REQUIRE(!reader.HasDatum());
+    }
+}
@@ -0,0 +1,104 @@
+#include <catch.hpp>
+
+#include "object_test.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <object.h>
+#include <reclaimer.h>
+#include <slab.h>
+
+static SlabStats StatsFor(size_t size) {
+    return GetSlabStats()[(size - 1) / 8];
+}
+
+TEST_CASE("Slab blocks are reused") {
+    auto before = StatsFor(24);
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10000; ++i) {
+        blocks.push_back(SlabAllocate(24));
+    }
+    auto during = StatsFor(24);
+    REQUIRE(during.live_blocks == before.live_blocks + 10000);
+    REQUIRE(during.allocations == before.allocations + 10000);
+    REQUIRE(during.reserved_bytes >= 10000 * 24);
+    REQUIRE(during.reserved_bytes % (64 << 10) == 0);
+
+    for (auto block : blocks) {
+        SlabFree(block, 24);
+    }
+    for (int i = 0; i < 10000; ++i) {
+        blocks[i] = SlabAllocate(24);
+    }
+    REQUIRE(StatsFor(24).reserved_bytes == during.reserved_bytes);
+    for (auto block : blocks) {
+        SlabFree(block, 24);
+    }
+    REQUIRE(StatsFor(24).live_blocks == before.live_blocks);
+
+    auto big = SlabAllocate(kMaxSlabSize + 1);
+    SlabFree(big, kMaxSlabSize + 1);
+}
+
+TEST_CASE("Heap objects live in slabs") {
+    auto before = StatsFor(sizeof(Cell));
+    Value list = MakeList(100000);
+    REQUIRE(StatsFor(sizeof(Cell)).live_blocks == before.live_blocks + 100000);
+    list = nullptr;
+    REQUIRE(StatsFor(sizeof(Cell)).live_blocks == before.live_blocks);
+}
+
+TEST_CASE("Slab blocks move between threads") {
+    auto before = StatsFor(sizeof(Cell));
+    Reclaimer reclaimer;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&reclaimer] {
+            for (int j = 0; j < 10; ++j) {
+                reclaimer.Retire(MakeList(10000));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    reclaimer.Wait();
+    REQUIRE(StatsFor(sizeof(Cell)).live_blocks == before.live_blocks);
+
+    // Blocks freed by the reclaimer, which keeps running, are reused.
+    auto reserved = StatsFor(sizeof(Cell)).reserved_bytes;
+    for (int round = 0; round < 20; ++round) {
+        reclaimer.Retire(MakeList(100000));
+        reclaimer.Wait();
+        REQUIRE(StatsFor(sizeof(Cell)).live_blocks == before.live_blocks);
+    }
+    REQUIRE(StatsFor(sizeof(Cell)).reserved_bytes == reserved);
+}
+
+// Run explicitly with `test_scheme_basic [benchmark]`.
+TEST_CASE("Heap list throughput", "[.benchmark]") {
+    constexpr int kSize = 10'000'000;
+    auto start = std::chrono::steady_clock::now();
+    Value list = MakeList(kSize);
+    auto built = std::chrono::steady_clock::now();
+    int64_t sum = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (auto node = As<Cell>(list); node; node = node->Advance(1)) {
+            sum += node->GetFirst().GetFixnum();
+        }
+    }
+    auto traversed = std::chrono::steady_clock::now();
+    list = nullptr;
+    auto freed = std::chrono::steady_clock::now();
+    REQUIRE(sum == 10 * (int64_t{kSize} * (kSize - 1) / 2));
+
+    using Ms = std::chrono::duration<double, std::milli>;
+    std::cout << "heap list of " << kSize << ": build " << Ms(built - start).count()
+              << " ms, traverse " << Ms(traversed - built).count() / 10 << " ms, free "
+              << Ms(freed - traversed).count() << " ms, "
+              << StatsFor(sizeof(Cell)).reserved_bytes / (1 << 20) << " MiB reserved"
+              << std::endl;
+}
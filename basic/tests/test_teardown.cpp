@@ -0,0 +1,132 @@
+#include <catch.hpp>
+
+#include "object_test.h"
+
+#include <collector.h>
+#include <reclaimer.h>
+#include <scheme.h>
+#include <slab.h>
+
+// Nested through the first slot: ((((... 0) 1) 2) ...).
+static Value MakeDeep(int depth) {
+    Value deep;
+    for (int i = 0; i < depth; ++i) {
+        deep = New<Cell>(std::move(deep), Value::Integer(i));
+    }
+    return deep;
+}
+
+// Complete binary tree of the given height.
+static Value MakeTree(int height) {
+    if (height == 0) {
+        return Value::Integer(0);
+    }
+    return New<Cell>(MakeTree(height - 1), MakeTree(height - 1));
+}
+
+static int Length(const Value& list) {
+    int length = 0;
+    for (auto node = list; Is<Cell>(node); node = As<Cell>(node)->GetSecond()) {
+        ++length;
+    }
+    return length;
+}
+
+TEST_CASE("Deep graphs are freed without recursion") {
+    Value list = MakeList(10'000'000);
+    list = nullptr;
+
+    Value deep = MakeDeep(1'000'000);
+    deep = nullptr;
+
+    // Zigzags between the two slots on every level.
+    Value zigzag;
+    for (int i = 0; i < 1'000'000; ++i) {
+        zigzag = i % 2 ? New<Cell>(std::move(zigzag), nullptr) : New<Cell>(nullptr, zigzag);
+    }
+    zigzag = nullptr;
+
+    Value tree = MakeTree(18);
+    tree = nullptr;
+}
+
+TEST_CASE("Teardown stops at shared objects") {
+    Value tail = MakeList(1000);
+    Value head = New<Cell>(MakeDeep(1000), tail);
+    Value deep_shared = As<Cell>(As<Cell>(head)->GetFirst())->GetFirst();
+    head = nullptr;
+    REQUIRE(tail.IsUnique());
+    REQUIRE(Length(tail) == 1000);
+    REQUIRE(deep_shared.IsUnique());
+
+    Collector collector;
+    CollectorScope scope{&collector};
+    Value young = New<Cell>(MakeDeep(100'000), MakeList(100'000));
+    young = nullptr;
+    collector.Minor();
+    REQUIRE(collector.GetStats().promoted_objects == 0);
+}
+
+static size_t LiveCells() {
+    return GetSlabStats()[(sizeof(Cell) - 1) / 8].live_blocks;
+}
+
+TEST_CASE("Background reclamation") {
+    constexpr size_t kSize = 10'000'000;
+    Reclaimer reclaimer;
+    auto before = LiveCells();
+    Value list = MakeList(kSize);
+    REQUIRE(LiveCells() == before + kSize);
+
+    // Retire only queues the list, the cells are freed on the reclaimer's thread meanwhile.
+    reclaimer.Retire(std::move(list));
+    REQUIRE(list == nullptr);
+    reclaimer.Retire(MakeDeep(1'000'000));
+    reclaimer.Wait();
+    REQUIRE(LiveCells() == before);
+    REQUIRE(reclaimer.GetReclaimed() == 2);
+
+    // Graphs with shared objects anywhere in them and arena objects are released by the caller.
+    Value shared = MakeList(10);
+    reclaimer.Retire(shared);
+    REQUIRE(shared.IsUnique());
+    reclaimer.Retire(New<Cell>(MakeDeep(10), New<Cell>(MakeList(10), shared)));
+    REQUIRE(shared.IsUnique());
+    {
+        Arena arena;
+        ArenaScope scope{&arena};
+        reclaimer.Retire(MakeList(10));
+    }
+    reclaimer.Retire(Value::Integer(1));
+    reclaimer.Wait();
+    REQUIRE(reclaimer.GetReclaimed() == 2);
+}
+
+TEST_CASE("Interpreter retires dropped definitions") {
+    std::string list = "(list";
+    for (int i = 0; i < 100000; ++i) {
+        list += " " + std::to_string(i);
+    }
+    list += ")";
+
+    Reclaimer reclaimer;
+    auto before = LiveCells();
+    {
+        Interpreter interpreter;
+        interpreter.SetReclaimer(&reclaimer);
+        interpreter.Run("(define l " + list + ")");
+        interpreter.Run("(define l 1)");
+        reclaimer.Wait();
+        REQUIRE(reclaimer.GetReclaimed() == 1);
+
+        // Still in use under the other name.
+        interpreter.Run("(define l " + list + ")");
+        interpreter.Run("(define m l)");
+        interpreter.Run("(define l 1)");
+        REQUIRE(interpreter.Run("(length m)") == "100000");
+        interpreter.Run("(define f (lambda () m))");
+    }
+    reclaimer.Wait();
+    REQUIRE(reclaimer.GetReclaimed() == 2);
+    REQUIRE(LiveCells() == before);
+}
@@ -2,8 +2,13 @@
 
 #include <error.h>
 #include <tokenizer.h>
+#include <char_scan.h>
+#include <symbol_table.h>
 
+#include <random>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 TEST_CASE("Tokenizer works on simple case") {
     std::stringstream ss{"4+)'."};
@@ -153,3 +158,175 @@ TEST_CASE("Empty string handled correctly") {
 
     REQUIRE(tokenizer.IsEnd());
 }
+
+TEST_CASE("Tokenizer works over a buffer") {
+    std::string input = "(foo 12 -3 #t)";
+    Tokenizer tokenizer{std::string_view{input}};
+
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::OPEN});
+
+    tokenizer.Next();
+    auto token = tokenizer.GetToken();
+    REQUIRE(token == Token{SymbolToken{"foo"}});
+    REQUIRE(std::get<SymbolToken>(token).GetName() == "foo");
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{12}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{-3}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BooleanToken::TRUE});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::CLOSE});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.IsEnd());
+}
+
+// Returns the tokens read before the end of the input or the first syntax error.
+static std::pair<std::vector<Token>, bool> TokenizeAll(std::string_view input) {
+    std::vector<Token> tokens;
+    try {
+        Tokenizer tokenizer{input};
+        while (!tokenizer.IsEnd()) {
+            tokens.push_back(tokenizer.GetToken());
+            tokenizer.Next();
+        }
+    } catch (const SyntaxError&) {
+        return {tokens, false};
+    }
+    return {tokens, true};
+}
+
+// Tokenized while the binary is initialized, which may happen before the file of the scanners
+// is. The runs are long enough to be scanned by them.
+static const auto kTokenizedAtStartup =
+    TokenizeAll("(                    a-symbol-of-more-than-32-chars-in-all 123456789012345678)");
+
+TEST_CASE("Tokenizers work during static initialization") {
+    REQUIRE(kTokenizedAtStartup.second);
+    REQUIRE(kTokenizedAtStartup.first.size() == 4);
+    REQUIRE(kTokenizedAtStartup.first[2] == Token{ConstantToken{123456789012345678}});
+}
+
+TEST_CASE("Vectorized scanning matches the scalar one") {
+    std::default_random_engine rng{42};
+    std::string_view alphabet = "abzAZ09<=>*/#[]?!-+ \t\n()'.";
+    std::uniform_int_distribution<size_t> letter(0, alphabet.size() - 1);
+    std::uniform_int_distribution<int> run(1, 80);
+
+    auto level = GetScanLevel();
+    for (int i = 0; i < 200; ++i) {
+        std::string input;
+        while (input.size() < 1000) {
+            input.append(run(rng), alphabet[letter(rng)]);
+        }
+
+        SetScanLevel(ScanLevel::SCALAR);
+        auto expected = TokenizeAll(input);
+        for (auto other : {ScanLevel::SSE2, ScanLevel::AVX2}) {
+            SetScanLevel(other);
+            REQUIRE(TokenizeAll(input) == expected);
+        }
+    }
+    SetScanLevel(level);
+}
+
+TEST_CASE("Symbol names are interned") {
+    Tokenizer tokenizer{std::string_view{"list-ref (list-ref)"}};
+    auto first = std::get<SymbolToken>(tokenizer.GetToken());
+    tokenizer.Next();
+    tokenizer.Next();
+    auto second = std::get<SymbolToken>(tokenizer.GetToken());
+
+    REQUIRE(first.name == second.name);
+    REQUIRE(first.name == Intern("list-ref"));
+    REQUIRE(first.name != Intern("list-tail"));
+}
+
+TEST_CASE("Symbol table from several threads") {
+    REQUIRE(FindInterned("never-interned-before?") == nullptr);
+    auto name = Intern("never-interned-before?");
+    REQUIRE(FindInterned("never-interned-before?") == name);
+    REQUIRE(*name == "never-interned-before?");
+
+    constexpr int kThreads = 4;
+    constexpr int kNames = 10000;
+    std::vector<std::vector<const std::string*>> interned(kThreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([i, &interned] {
+            for (int j = 0; j < kNames; ++j) {
+                interned[i].push_back(Intern("thread-symbol-" + std::to_string(j)));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int j = 0; j < kNames; ++j) {
+        REQUIRE(*interned[0][j] == "thread-symbol-" + std::to_string(j));
+        for (int i = 1; i < kThreads; ++i) {
+            REQUIRE(interned[i][j] == interned[0][j]);
+        }
+    }
+}
+
+TEST_CASE("64-bit literals") {
+    std::stringstream ss{"9223372036854775807 -9223372036854775808 +0012"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{INT64_MAX}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{INT64_MIN}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{12}});
+
+    // Anything longer is a bignum.
+    std::stringstream big{"9223372036854775808 -9223372036854775809 +100000000000000000000000"};
+    tokenizer = Tokenizer{&big};
+    REQUIRE(tokenizer.GetToken() ==
+            Token{BigConstantToken{BigInt::FromString("9223372036854775808")}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() ==
+            Token{BigConstantToken{BigInt::FromString("-9223372036854775809")}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() ==
+            Token{BigConstantToken{BigInt::FromString("100000000000000000000000")}});
+
+    tokenizer.Next();
+    REQUIRE(tokenizer.IsEnd());
+}
+
+TEST_CASE("Tokenizers can be moved") {
+    // Short enough to stay inside the strings, which doesn't move with them.
+    std::stringstream first{"1"};
+    std::stringstream second{"(a 2)"};
+    Tokenizer tokenizer{&first};
+    tokenizer = Tokenizer{&second};
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::OPEN});
+
+    tokenizer.Next();
+    Tokenizer moved{std::move(tokenizer)};
+    REQUIRE(tokenizer.IsEnd());
+    REQUIRE(moved.GetToken() == Token{SymbolToken{"a"}});
+    moved.Next();
+    REQUIRE(moved.GetToken() == Token{ConstantToken{2}});
+    moved.Next();
+    REQUIRE(moved.GetToken() == Token{BracketToken::CLOSE});
+    moved.Next();
+    REQUIRE(moved.IsEnd());
+
+    std::string buffer = "#t";
+    tokenizer = Tokenizer{std::string_view(buffer)};
+    REQUIRE(tokenizer.GetToken() == Token{BooleanToken::TRUE});
+    tokenizer.Next();
+    REQUIRE(tokenizer.IsEnd());
+}
@@ -0,0 +1,49 @@
+#include <catch.hpp>
+
+#include <char_scan.h>
+#include <tokenizer.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+static std::string MakeScript(size_t size) {
+    std::default_random_engine rng{42};
+    std::uniform_int_distribution<int> indent(0, 24);
+    std::uniform_int_distribution<int> number(0, 99999999);
+    std::string script;
+    while (script.size() < size) {
+        script.append(indent(rng), ' ');
+        script += "(list-tail (make-some-rather-long-symbol-name? ";
+        script += std::to_string(number(rng));
+        script += " another-symbol-with-a-long-name!) ";
+        script += std::to_string(number(rng));
+        script += ")\n";
+    }
+    return script;
+}
+
+// Run explicitly with `test_scheme_basic [benchmark]`.
+TEST_CASE("Tokenizer throughput", "[.benchmark]") {
+    auto script = MakeScript(16 << 20);
+    auto level = GetScanLevel();
+
+    for (auto other : {ScanLevel::SCALAR, ScanLevel::SSE2, ScanLevel::AVX2}) {
+        SetScanLevel(other);
+        if (GetScanLevel() != other) {
+            continue;
+        }
+        size_t tokens = 0;
+        auto start = std::chrono::steady_clock::now();
+        Tokenizer tokenizer{std::string_view{script}};
+        while (!tokenizer.IsEnd()) {
+            ++tokens;
+            tokenizer.Next();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "scan level " << static_cast<int>(other) << ": " << tokens << " tokens, "
+                  << script.size() / elapsed.count() / (1 << 20) << " MB/s" << std::endl;
+    }
+    SetScanLevel(level);
+}
@@ -1,6 +1,18 @@
 #include <tokenizer.h>
 #include <error.h>
 
+#include <char_scan.h>
+#include <symbol_table.h>
+
+#include <charconv>
+
+SymbolToken::SymbolToken(std::string_view name) : name(Intern(name)) {
+}
+
+const std::string& SymbolToken::GetName() const {
+    return *name;
+}
+
 bool SymbolToken::operator==(const SymbolToken& other) const {
     return name == other.name;
 }
@@ -17,20 +29,48 @@ bool ConstantToken::operator==(const ConstantToken& other) const {
     return value == other.value;
 }
 
+bool BigConstantToken::operator==(const BigConstantToken& other) const {
+    return value == other.value;
+}
+
 Tokenizer::Tokenizer(std::istream* in) : in_(in) {
-    x_ = in_->get();
-    for (char x = 65; x < 91; ++x) {
-        symbols_allowed_.insert(x);
-        symbols_allowed_begin_.insert(x);
-    }
-    for (char x = 97; x < 123; ++x) {
-        symbols_allowed_.insert(x);
-        symbols_allowed_begin_.insert(x);
+    token_begin_ = pos_ = end_ = buffer_.data();
+    Next();
+}
+
+Tokenizer::Tokenizer(std::string_view buffer)
+    : token_begin_(buffer.data()), pos_(buffer.data()), end_(buffer.data() + buffer.size()) {
+    Next();
+}
+
+Tokenizer::Tokenizer(Tokenizer&& other) noexcept {
+    *this = std::move(other);
+}
+
+Tokenizer& Tokenizer::operator=(Tokenizer&& other) noexcept {
+    if (this == &other) {
+        return *this;
     }
-    for (char x = 48; x < 58; ++x) {
-        symbols_allowed_.insert(x);
+    cur_token_ = std::move(other.cur_token_);
+    in_ = other.in_;
+    is_ended_ = other.is_ended_;
+    dot_used_ = other.dot_used_;
+    token_begin_ = other.token_begin_;
+    pos_ = other.pos_;
+    end_ = other.end_;
+    if (in_) {
+        // A short buffer is kept inside the string, so its data doesn't move with it.
+        auto base = other.buffer_.data();
+        buffer_ = std::move(other.buffer_);
+        token_begin_ = buffer_.data() + (other.token_begin_ - base);
+        pos_ = buffer_.data() + (other.pos_ - base);
+        end_ = buffer_.data() + (other.end_ - base);
     }
-    Next();
+    other.in_ = nullptr;
+    other.buffer_.clear();
+    other.token_begin_ = other.pos_ = other.end_ = nullptr;
+    other.is_ended_ = true;
+    return *this;
 }
 
 bool Tokenizer::IsEnd() {
@@ -41,149 +81,117 @@ Token Tokenizer::GetToken() {
     return cur_token_;
 }
 
-void Tokenizer::Next() {
-    if (x_ == std::istream::traits_type::eof()) {
-        is_ended_ = true;
+int Tokenizer::Peek() {
+    if (pos_ == end_ && !Refill()) {
+        return std::istream::traits_type::eof();
+    }
+    return static_cast<unsigned char>(*pos_);
+}
+
+// Stream mode only: pulls whatever the stream can give without blocking (at least one char),
+// keeping the unfinished token at the front of the buffer.
+bool Tokenizer::Refill() {
+    if (in_ == nullptr) {
+        return false;
+    }
+    auto x = in_->get();
+    if (x == std::istream::traits_type::eof()) {
+        return false;
+    }
+    size_t keep_from = token_begin_ - buffer_.data();
+    size_t pos = pos_ - buffer_.data();
+    buffer_.erase(0, keep_from);
+    pos -= keep_from;
+    buffer_ += static_cast<char>(x);
+    auto available = in_->rdbuf()->in_avail();
+    if (available > 0) {
+        size_t size = buffer_.size();
+        buffer_.resize(size + available);
+        in_->read(buffer_.data() + size, available);
+        buffer_.resize(size + in_->gcount());
+    }
+    token_begin_ = buffer_.data();
+    pos_ = token_begin_ + pos;
+    end_ = buffer_.data() + buffer_.size();
+    return true;
+}
+
+void Tokenizer::ReadNumber() {
+    do {
+        pos_ = SkipDigits(pos_, end_);
+    } while (pos_ == end_ && Refill());
+    // Refill may have moved the buffer, so the literal is located only after the loop.
+    // from_chars takes the minus sign but not the plus one.
+    const char* begin = token_begin_ + (*token_begin_ == '+' ? 1 : 0);
+    int64_t value = 0;
+    if (std::from_chars(begin, pos_, value).ec == std::errc::result_out_of_range) {
+        cur_token_ = BigConstantToken{BigInt::FromString(std::string_view(begin, pos_ - begin))};
         return;
     }
-    if (isspace(x_)) {
-        x_ = in_->get();
-        Next();
+    cur_token_ = ConstantToken{value};
+}
+
+void Tokenizer::ReadSymbol() {
+    do {
+        pos_ = SkipSymbol(pos_, end_);
+    } while (pos_ == end_ && Refill());
+    cur_token_ = SymbolToken{std::string_view(token_begin_, pos_ - token_begin_)};
+}
+
+void Tokenizer::Next() {
+    do {
+        token_begin_ = pos_ = SkipSpaces(pos_, end_);
+    } while (pos_ == end_ && Refill());
+    auto x = Peek();
+    if (x == std::istream::traits_type::eof()) {
+        is_ended_ = true;
         return;
     }
-    if (x_ == '(') {
+    ++pos_;
+    if (x == '(') {
         cur_token_ = BracketToken::OPEN;
-        x_ = in_->get();
         return;
     }
-    if (x_ == ')') {
+    if (x == ')') {
         cur_token_ = BracketToken::CLOSE;
-        x_ = in_->get();
         return;
     }
-    if (x_ == '\'') {
+    if (x == '\'') {
         cur_token_ = QuoteToken();
-        x_ = in_->get();
         return;
     }
-    if (x_ == '.') {
+    if (x == '.') {
         cur_token_ = DotToken();
-        x_ = in_->get();
         dot_used_ = true;
         return;
     }
-    if (isdigit(x_)) {
-        std::string num;
-        num += x_;
-        x_ = in_->get();
-        while (x_ != std::istream::traits_type::eof() && isdigit(x_)) {
-            num += x_;
-            x_ = in_->get();
-        }
-        cur_token_ = ConstantToken{std::stoi(num)};
-        return;
-    }
-    if (x_ == '+') {
-        x_ = in_->get();
-        if (x_ == ' ') {
-            cur_token_ = SymbolToken{"+"};
-            x_ = in_->get();
-            return;
-        }
-        if (x_ == std::istream::traits_type::eof()) {
-            cur_token_ = SymbolToken{"+"};
-            return;
-        }
-        if (isdigit(x_)) {
-            std::string num;
-            num += x_;
-            x_ = in_->get();
-            while (x_ != std::istream::traits_type::eof() && isdigit(x_)) {
-                num += x_;
-                x_ = in_->get();
-            }
-            cur_token_ = ConstantToken{std::stoi(num)};
-            return;
-        }
-        cur_token_ = SymbolToken{"+"};
+    if (HasClass(x, kDigit)) {
+        ReadNumber();
         return;
     }
-    if (x_ == '-') {
-        x_ = in_->get();
-        if (x_ == ' ') {
-            cur_token_ = SymbolToken{"-"};
-            x_ = in_->get();
+    if (x == '+' || x == '-') {
+        if (HasClass(Peek(), kDigit)) {
+            ReadNumber();
             return;
         }
-        if (x_ == std::istream::traits_type::eof()) {
-            cur_token_ = SymbolToken{"-"};
-            return;
-        }
-        if (isdigit(x_)) {
-            std::string num;
-            num += x_;
-            x_ = in_->get();
-            while (x_ != std::istream::traits_type::eof() && isdigit(x_)) {
-                num += x_;
-                x_ = in_->get();
-            }
-            cur_token_ = ConstantToken{std::stoi(num) * (-1)};
-            return;
-        }
-        cur_token_ = SymbolToken{"-"};
+        cur_token_ = SymbolToken{std::string_view(token_begin_, 1)};
         return;
     }
-    if (x_ == '#') {
-        std::string ans;
-        ans += x_;
-        x_ = in_->get();
-        if (x_ == std::istream::traits_type::eof()) {
-            cur_token_ = SymbolToken{ans};
-            return;
-        }
-        if (x_ == ' ') {
-            cur_token_ = SymbolToken{ans};
-            x_ = in_->get();
-            return;
-        }
-        if (x_ == 't' || x_ == 'f') {
-            ans += x_;
-            x_ = in_->get();
-            if (x_ == std::istream::traits_type::eof()) {
-                cur_token_ = ans.back() == 't' ? BooleanToken::TRUE : BooleanToken::FALSE;
-                return;
-            }
-            if (x_ == ' ') {
-                cur_token_ = ans.back() == 't' ? BooleanToken::TRUE : BooleanToken::FALSE;
-                x_ = in_->get();
+    if (x == '#') {
+        auto next = Peek();
+        if (next == 't' || next == 'f') {
+            ++pos_;
+            auto after = Peek();
+            if (!HasClass(after, kSymbol)) {
+                cur_token_ = next == 't' ? BooleanToken::TRUE : BooleanToken::FALSE;
                 return;
             }
-            while (x_ != std::istream::traits_type::eof() &&
-                   symbols_allowed_.find(x_) != symbols_allowed_.end()) {
-                ans += x_;
-                x_ = in_->get();
-            }
-            cur_token_ = SymbolToken{ans};  // probably add #t(sth incorrect)
-            return;
-        }
-        while (x_ != std::istream::traits_type::eof() &&
-               symbols_allowed_.find(x_) != symbols_allowed_.end()) {
-            ans += x_;
-            x_ = in_->get();
         }
-        cur_token_ = SymbolToken{ans};
+        ReadSymbol();
         return;
     }
-    if (symbols_allowed_begin_.find(x_) != symbols_allowed_begin_.end()) {
-        std::string ans;
-        ans += x_;
-        x_ = in_->get();
-        while (x_ != std::istream::traits_type::eof() &&
-               symbols_allowed_.find(x_) != symbols_allowed_.end()) {
-            ans += x_;
-            x_ = in_->get();
-        }
-        cur_token_ = SymbolToken{ans};
+    if (HasClass(x, kSymbolBegin)) {
+        ReadSymbol();
         return;
     }
     throw SyntaxError("invalid symbol");
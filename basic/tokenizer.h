@@ -1,14 +1,23 @@
 #pragma once
 
+#include <cstdint>
 #include <variant>
 #include <optional>
 #include <istream>
-#include <unordered_set>
+#include <string>
+#include <string_view>
+
+#include <bigint.h>
 
 struct SymbolToken {
-    std::string name;
+    SymbolToken(std::string_view name);
+
+    const std::string& GetName() const;
 
     bool operator==(const SymbolToken& other) const;
+
+    // Interned, see symbol_table.h.
+    const std::string* name;
 };
 
 struct QuoteToken {
@@ -24,18 +33,36 @@ enum class BracketToken { OPEN, CLOSE };
 enum class BooleanToken { TRUE, FALSE };
 
 struct ConstantToken {
-    int value;
+    int64_t value;
 
     bool operator==(const ConstantToken& other) const;
 };
 
-using Token =
-    std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken, BooleanToken>;
+// An integer literal outside of int64.
+struct BigConstantToken {
+    BigInt value;
+
+    bool operator==(const BigConstantToken& other) const;
+};
+
+using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken,
+                           BooleanToken, BigConstantToken>;
 
 class Tokenizer {
 public:
     Tokenizer(std::istream* in);
 
+    // Works directly over a contiguous buffer without copying it.
+    // The buffer has to outlive the tokenizer.
+    Tokenizer(std::string_view buffer);
+
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
+
+    // The position moves along with the buffer of a stream, the one moved from is at its end.
+    Tokenizer(Tokenizer&& other) noexcept;
+    Tokenizer& operator=(Tokenizer&& other) noexcept;
+
     bool IsEnd();
 
     void Next();
@@ -45,12 +72,17 @@ public:
     bool DotUsed();
 
 private:
+    int Peek();
+    bool Refill();
+    void ReadNumber();
+    void ReadSymbol();
+
     Token cur_token_{};
-    std::istream* in_;
+    std::istream* in_ = nullptr;
+    std::string buffer_;
+    const char* token_begin_ = nullptr;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
     bool is_ended_ = false;
-    std::unordered_set<char> symbols_allowed_ = {'<', '=', '>', '*', '/', '#',
-                                                 '?', '!', '-', '[', ']'};
-    std::unordered_set<char> symbols_allowed_begin_ = {'<', '=', '>', '*', '/', '#', '[', ']'};
-    char x_{};
     bool dot_used_ = false;
-};
\ No newline at end of file
+};